@@ -0,0 +1,480 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <FileTapeLibrary.h>
+
+/*
+ * YCSB-style workloads on BTree
+ * load phase inserts records with ids 0..records - 1, run phase mixes reads, updates, inserts (of next ids)
+ * and scans (of records following key of chosen id in order of keys)
+ * ids are mapped to keys with a bijective mix, so keys don't come in sorted order
+ */
+
+enum class operation { read, update, insert, scan };
+const char* OPERATION_NAMES[] = { "read", "update", "insert", "scan" };
+
+enum class id_distribution {
+	uniform,
+	// popular ids are spread over all ids
+	zipfian,
+	// most recently inserted ids are the most popular
+	latest
+};
+
+struct WorkloadOptions {
+	unsigned long long records = 10000;
+	unsigned long long operations = 10000;
+	// proportions of operations
+	double read = 0.5;
+	double update = 0.5;
+	double insert = 0;
+	double scan = 0;
+	id_distribution distribution = id_distribution::zipfian;
+	std::size_t scan_length = 100;
+	std::size_t record_width = FileTapeLibrary::ArrayRecord::MAX_SIZE;
+	std::size_t cache_pages = FileTapeLibrary::PageCache::DEFAULT_CAPACITY;
+	FileTapeLibrary::sync_policy sync = FileTapeLibrary::sync_policy::on_flush;
+	std::size_t page_size = FileTapeLibrary::TreePage::DEFAULT_SIZE;
+	unsigned long long seed = std::mt19937_64::default_seed;
+	std::string directory = "./data";
+	std::string csv_path;
+};
+
+// predefined mixes of YCSB core workloads
+void set_workload(WorkloadOptions& options, char workload) {
+	switch (workload) {
+	case 'a':
+		options.read = 0.5, options.update = 0.5, options.insert = 0, options.scan = 0;
+		options.distribution = id_distribution::zipfian;
+		break;
+	case 'b':
+		options.read = 0.95, options.update = 0.05, options.insert = 0, options.scan = 0;
+		options.distribution = id_distribution::zipfian;
+		break;
+	case 'c':
+		options.read = 1, options.update = 0, options.insert = 0, options.scan = 0;
+		options.distribution = id_distribution::zipfian;
+		break;
+	case 'd':
+		options.read = 0.95, options.update = 0, options.insert = 0.05, options.scan = 0;
+		options.distribution = id_distribution::latest;
+		break;
+	case 'e':
+		options.read = 0, options.update = 0, options.insert = 0.05, options.scan = 0.95;
+		options.distribution = id_distribution::zipfian;
+		break;
+	default:
+		throw std::exception("Unknown workload");
+	}
+}
+
+FileTapeLibrary::index_t get_key(unsigned long long id) {
+	// finalizer of splitmix64 - bijection, so different ids never share a key
+	auto key = id + 0x9e3779b97f4a7c15ull;
+	key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+	key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+	return key ^ (key >> 31);
+}
+
+// Zipfian ranks 0..items - 1 (rank 0 is the most popular) - algorithm of Gray et al., as in YCSB
+class ZipfianGenerator {
+public:
+	static constexpr double THETA = 0.99;
+
+	ZipfianGenerator(unsigned long long items) : items(items) {
+		for (auto i = 1ull; i <= items; ++i) {
+			zetan += 1.0 / std::pow(static_cast<double>(i), THETA);
+		}
+		auto zeta2 = 1.0 + 1.0 / std::pow(2.0, THETA);
+
+		alpha = 1.0 / (1.0 - THETA);
+		eta = (1.0 - std::pow(2.0 / items, 1.0 - THETA)) / (1.0 - zeta2 / zetan);
+	}
+
+	template <typename Engine>
+	unsigned long long operator()(Engine& engine) {
+		auto u = std::uniform_real_distribution<double>(0.0, 1.0)(engine);
+		auto uz = u * zetan;
+
+		if (uz < 1.0) {
+			return 0;
+		}
+		if (uz < 1.0 + std::pow(0.5, THETA)) {
+			return std::min(1ull, items - 1);
+		}
+
+		auto rank = static_cast<unsigned long long>(items * std::pow(eta * u - eta + 1.0, alpha));
+		return std::min(rank, items - 1);
+	}
+
+private:
+	unsigned long long items;
+	double zetan = 0;
+	double alpha;
+	double eta;
+};
+
+// latencies in nanoseconds - 16 buckets per power of two, so values are kept with ~6% precision
+class LatencyHistogram {
+public:
+	static constexpr std::size_t SUB_BUCKETS = 16;
+
+	void record(unsigned long long nanoseconds) {
+		++buckets[get_bucket(nanoseconds)];
+		++count;
+	}
+
+	unsigned long long get_count() const {
+		return count;
+	}
+
+	// lower bound of bucket which holds the percentile
+	unsigned long long get_percentile(double percentile) const {
+		auto rank = static_cast<unsigned long long>(std::ceil(percentile / 100.0 * count));
+		auto seen = 0ull;
+
+		for (std::size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+			seen += buckets[bucket];
+			if (seen >= std::max(1ull, rank)) {
+				return get_bucket_value(bucket);
+			}
+		}
+
+		return 0;
+	}
+
+	void write_csv(std::ostream& csv, const std::string& name) const {
+		for (std::size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+			if (buckets[bucket] > 0) {
+				csv << name << ',' << get_bucket_value(bucket) << ',' << buckets[bucket] << '\n';
+			}
+		}
+	}
+
+private:
+	static std::size_t get_bucket(unsigned long long value) {
+		if (value < SUB_BUCKETS) {
+			return static_cast<std::size_t>(value);
+		}
+
+		auto exponent = std::size_t(0);
+		while ((value >> exponent) >= 2 * SUB_BUCKETS) {
+			++exponent;
+		}
+		// value >> exponent is in [SUB_BUCKETS, 2 * SUB_BUCKETS)
+		return (exponent + 1) * SUB_BUCKETS + static_cast<std::size_t>((value >> exponent) - SUB_BUCKETS);
+	}
+
+	static unsigned long long get_bucket_value(std::size_t bucket) {
+		if (bucket < SUB_BUCKETS) {
+			return bucket;
+		}
+
+		auto exponent = bucket / SUB_BUCKETS - 1;
+		return (SUB_BUCKETS + bucket % SUB_BUCKETS) << exponent;
+	}
+
+	std::array<unsigned long long, 64 * SUB_BUCKETS> buckets = {};
+	unsigned long long count = 0;
+};
+
+struct OperationStatistics {
+	LatencyHistogram latencies;
+	double seconds = 0;
+	unsigned long long failures = 0;
+	unsigned long long page_reads = 0;
+	unsigned long long page_writes = 0;
+};
+
+FileTapeLibrary::ArrayRecord make_record(unsigned long long id, std::size_t width, std::mt19937_64& engine) {
+	auto record = FileTapeLibrary::ArrayRecord(width);
+	for (std::size_t i = 0; i < width; ++i) {
+		record[i] = static_cast<int>(engine() ^ id);
+	}
+	return record;
+}
+
+class Workload {
+public:
+	Workload(const WorkloadOptions& options)
+		: options(options),
+		database(options.directory + "/ycsb_metadata.dat", options.directory + "/ycsb_index.dat", options.directory + "/ycsb_records.dat", options.record_width, options.cache_pages, options.sync, options.page_size),
+		engine(options.seed),
+		zipfian(std::max(1ull, options.records)) {
+		database.clear();
+	}
+
+	void load() {
+		auto& statistics = load_statistics;
+		for (auto id = 0ull; id < options.records; ++id) {
+			measure(statistics, [&]() { insert(id); });
+		}
+		inserted = options.records;
+	}
+
+	void run() {
+		auto proportions = std::discrete_distribution<int>({ options.read, options.update, options.insert, options.scan });
+
+		for (auto i = 0ull; i < options.operations; ++i) {
+			auto type = static_cast<operation>(proportions(engine));
+			auto& statistics = run_statistics[static_cast<std::size_t>(type)];
+
+			switch (type) {
+			case operation::read: {
+				auto id = next_id();
+				measure(statistics, [&]() { database.read_record(get_key(id)); });
+				break;
+			}
+			case operation::update: {
+				auto id = next_id();
+				auto record = make_record(id, options.record_width, engine);
+				measure(statistics, [&]() { database.update_record(get_key(id), record); });
+				break;
+			}
+			case operation::insert:
+				measure(statistics, [&]() { insert(inserted); });
+				++inserted;
+				break;
+			case operation::scan: {
+				auto id = next_id();
+				auto length = std::uniform_int_distribution<std::size_t>(1, options.scan_length)(engine);
+				// up to length records in order of keys, starting at key of chosen id
+				measure(statistics, [&]() {
+					auto cursor = database.scan(get_key(id), FileTapeLibrary::NIL_INDEX, length);
+					for (std::size_t scanned = 0; scanned < length && !cursor.is_empty(); ++scanned) {
+						cursor.read_next_record();
+					}
+				});
+				break;
+			}
+			}
+		}
+	}
+
+	void report(std::ostream& out) {
+		// sizes of files include pages waiting in cache
+		database.flush();
+
+		auto lookups = database.get_cache_hits() + database.get_cache_misses();
+		out << "page cache: " << database.get_cache_hits() << " hits, " << database.get_cache_misses() << " misses ("
+			<< (lookups > 0 ? 100.0 * database.get_cache_hits() / lookups : 0.0) << "% hits)" << std::endl;
+		out << "index file: " << std::filesystem::file_size(options.directory + "/ycsb_index.dat") << " bytes, "
+			<< "records file: " << std::filesystem::file_size(options.directory + "/ycsb_records.dat") << " bytes" << std::endl;
+
+		report_operation(out, "load", load_statistics);
+		for (std::size_t type = 0; type < run_statistics.size(); ++type) {
+			report_operation(out, OPERATION_NAMES[type], run_statistics[type]);
+		}
+	}
+
+	void write_csv(const std::string& path) const {
+		auto csv = std::ofstream(path, std::ios_base::binary);
+		csv << "operation,latency_ns,count\n";
+
+		load_statistics.latencies.write_csv(csv, "load");
+		for (std::size_t type = 0; type < run_statistics.size(); ++type) {
+			run_statistics[type].latencies.write_csv(csv, OPERATION_NAMES[type]);
+		}
+	}
+
+private:
+	void insert(unsigned long long id) {
+		database.insert_record(get_key(id), make_record(id, options.record_width, engine));
+	}
+
+	// id of existing record chosen with the distribution of the workload
+	unsigned long long next_id() {
+		switch (options.distribution) {
+		case id_distribution::uniform:
+			return std::uniform_int_distribution<unsigned long long>(0, inserted - 1)(engine);
+		case id_distribution::zipfian:
+			// popular ranks are scattered over ids
+			return get_key(zipfian(engine)) % inserted;
+		case id_distribution::latest:
+		default:
+			return inserted - 1 - std::min(zipfian(engine), inserted - 1);
+		}
+	}
+
+	template <typename Operation>
+	void measure(OperationStatistics& statistics, Operation operation) {
+		auto page_reads = database.get_page_reads();
+		auto page_writes = database.get_page_writes();
+		auto start = std::chrono::steady_clock::now();
+
+		try {
+			operation();
+		}
+		catch (std::exception&) {
+			++statistics.failures;
+		}
+
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		statistics.latencies.record(static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+		statistics.seconds += std::chrono::duration<double>(elapsed).count();
+		statistics.page_reads += database.get_page_reads() - page_reads;
+		statistics.page_writes += database.get_page_writes() - page_writes;
+	}
+
+	static void report_operation(std::ostream& out, const char* name, const OperationStatistics& statistics) {
+		auto count = statistics.latencies.get_count();
+		if (count == 0) {
+			return;
+		}
+
+		out << name << ": " << count << " operations, " << count / statistics.seconds << " ops/s, "
+			<< "p50 " << statistics.latencies.get_percentile(50) / 1e3 << " us, "
+			<< "p99 " << statistics.latencies.get_percentile(99) / 1e3 << " us, "
+			<< "p99.9 " << statistics.latencies.get_percentile(99.9) / 1e3 << " us, "
+			<< static_cast<double>(statistics.page_reads) / count << " page reads/op, "
+			<< static_cast<double>(statistics.page_writes) / count << " page writes/op, "
+			<< statistics.failures << " failed" << std::endl;
+	}
+
+	WorkloadOptions options;
+	FileTapeLibrary::BTree database;
+	std::mt19937_64 engine;
+	ZipfianGenerator zipfian;
+	unsigned long long inserted = 0;
+
+	OperationStatistics load_statistics;
+	std::array<OperationStatistics, 4> run_statistics;
+};
+
+// usage: BTree benchmark [options]
+//          --workload a                  YCSB core workload: a (50% reads, 50% updates), b (95/5), c (reads),
+//                                        d (95% reads, 5% inserts, latest), e (95% scans, 5% inserts)
+//          --read 0.5 --update 0.5       proportions of operations (instead of workload)
+//          --insert 0 --scan 0
+//          --distribution zipfian        uniform, zipfian or latest
+//          --records 10000               records of load phase (up to 1e8)
+//          --operations 10000            operations of run phase
+//          --scan-length 100             longest scan
+//          --record-width 15             ints in record slot
+//          --cache-pages 1024            pages of index kept in memory
+//          --sync on-flush               none, on-flush or every-operation
+//          --page-size 4096              size of index pages of new tree
+//          --seed 1
+//          --directory ./data            directory of tree files
+//          --csv histogram.csv           latency histograms
+int main(int argc, char** argv) {
+	auto options = WorkloadOptions();
+
+	try {
+		for (int i = 1; i + 1 < argc; i += 2) {
+			auto name = std::string(argv[i]);
+			auto value = std::string(argv[i + 1]);
+
+			if (name == "--workload") {
+				set_workload(options, value.empty() ? ' ' : static_cast<char>(std::tolower(value[0])));
+			}
+			else if (name == "--read") {
+				options.read = std::stod(value);
+			}
+			else if (name == "--update") {
+				options.update = std::stod(value);
+			}
+			else if (name == "--insert") {
+				options.insert = std::stod(value);
+			}
+			else if (name == "--scan") {
+				options.scan = std::stod(value);
+			}
+			else if (name == "--distribution") {
+				if (value == "uniform") {
+					options.distribution = id_distribution::uniform;
+				}
+				else if (value == "zipfian") {
+					options.distribution = id_distribution::zipfian;
+				}
+				else if (value == "latest") {
+					options.distribution = id_distribution::latest;
+				}
+				else {
+					throw std::exception("Unknown distribution");
+				}
+			}
+			else if (name == "--records") {
+				options.records = static_cast<unsigned long long>(std::stod(value));
+			}
+			else if (name == "--operations") {
+				options.operations = static_cast<unsigned long long>(std::stod(value));
+			}
+			else if (name == "--scan-length") {
+				options.scan_length = std::max(1ull, std::stoull(value));
+			}
+			else if (name == "--record-width") {
+				options.record_width = std::stoull(value);
+			}
+			else if (name == "--cache-pages") {
+				options.cache_pages = std::stoull(value);
+			}
+			else if (name == "--sync") {
+				if (value == "none") {
+					options.sync = FileTapeLibrary::sync_policy::none;
+				}
+				else if (value == "on-flush") {
+					options.sync = FileTapeLibrary::sync_policy::on_flush;
+				}
+				else if (value == "every-operation") {
+					options.sync = FileTapeLibrary::sync_policy::every_operation;
+				}
+				else {
+					throw std::exception("Unknown sync policy");
+				}
+			}
+			else if (name == "--page-size") {
+				options.page_size = std::stoull(value);
+			}
+			else if (name == "--seed") {
+				options.seed = std::stoull(value);
+			}
+			else if (name == "--directory") {
+				options.directory = value;
+			}
+			else if (name == "--csv") {
+				options.csv_path = value;
+			}
+			else {
+				throw std::exception("Unknown option");
+			}
+		}
+
+		if (options.records == 0) {
+			throw std::exception("Load phase needs at least one record");
+		}
+		if (options.record_width == 0 || options.record_width > FileTapeLibrary::ArrayRecord::MAX_SIZE) {
+			throw std::exception("Wrong record width");
+		}
+
+		std::filesystem::create_directories(options.directory);
+		// tree of previous run would keep its page size
+		for (const auto* file : { "/ycsb_metadata.dat", "/ycsb_index.dat", "/ycsb_records.dat" }) {
+			std::filesystem::remove(options.directory + file);
+		}
+
+		auto workload = Workload(options);
+		workload.load();
+		workload.run();
+		workload.report(std::cout);
+
+		if (!options.csv_path.empty()) {
+			workload.write_csv(options.csv_path);
+		}
+
+		return 0;
+	}
+	catch (std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+}
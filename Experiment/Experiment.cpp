@@ -1,30 +1,440 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
 #include <tuple>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
 
 #include <FileTapeLibrary.h>
 
-bool sort_policy(FileTapeLibrary::ArrayRecord ar1, FileTapeLibrary::ArrayRecord ar2) {
-	return ar1.max() <= ar2.max();
+// counters of the process - differences of two measurements describe one run
+struct ProcessCounters {
+	double cpu_seconds = 0;
+	unsigned long long bytes_read = 0;
+	unsigned long long bytes_written = 0;
+};
+
+ProcessCounters measure_process() {
+	auto counters = ProcessCounters();
+
+#if defined(_WIN32)
+	FILETIME creation, exit, kernel, user;
+	if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+		auto to_seconds = [](const FILETIME& time) {
+			return ((static_cast<unsigned long long>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1e7;
+		};
+		counters.cpu_seconds = to_seconds(kernel) + to_seconds(user);
+	}
+
+	IO_COUNTERS io;
+	if (GetProcessIoCounters(GetCurrentProcess(), &io)) {
+		counters.bytes_read = io.ReadTransferCount;
+		counters.bytes_written = io.WriteTransferCount;
+	}
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		counters.cpu_seconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+	}
+
+	// bytes passed through read and write calls
+	auto io = std::ifstream("/proc/self/io");
+	auto name = std::string();
+	auto value = 0ull;
+	while (io >> name >> value) {
+		if (name == "rchar:") {
+			counters.bytes_read = value;
+		}
+		else if (name == "wchar:") {
+			counters.bytes_written = value;
+		}
+	}
+#endif
+
+	return counters;
+}
+
+// peak resident memory is measured from here (on Windows - from start of the process)
+void reset_peak_memory() {
+#if !defined(_WIN32)
+	std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+unsigned long long get_peak_memory() {
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS memory;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory))) {
+		return memory.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	auto status = std::ifstream("/proc/self/status");
+	auto line = std::string();
+	while (std::getline(status, line)) {
+		if (line.rfind("VmHWM:", 0) == 0) {
+			return std::stoull(line.substr(6)) * 1024;
+		}
+	}
+	return 0;
+#endif
+}
+
+std::vector<std::string> split(const std::string& text, char separator) {
+	auto parts = std::vector<std::string>();
+	auto stream = std::istringstream(text);
+	auto part = std::string();
+
+	while (std::getline(stream, part, separator)) {
+		if (!part.empty()) {
+			parts.push_back(part);
+		}
+	}
+
+	return parts;
 }
 
+const std::map<std::string, FileTapeLibrary::key_distribution> DISTRIBUTIONS = {
+	{ "uniform", FileTapeLibrary::key_distribution::uniform },
+	{ "sorted", FileTapeLibrary::key_distribution::sorted },
+	{ "reverse", FileTapeLibrary::key_distribution::reverse_sorted },
+	{ "nearly-sorted", FileTapeLibrary::key_distribution::nearly_sorted },
+	{ "few-unique", FileTapeLibrary::key_distribution::few_unique },
+	{ "zipf", FileTapeLibrary::key_distribution::zipf },
+	{ "sawtooth", FileTapeLibrary::key_distribution::sawtooth }
+};
+
+struct BenchmarkOptions {
+	std::vector<unsigned long long> records_numbers = { 10, 100, 1000, 10000, 100000 };
+	std::vector<std::string> distributions = { "uniform" };
+	std::vector<std::size_t> buffer_sizes = { FileTapeLibrary::BufferedTape::DEFAULT_BUFFER_SIZE };
+	// natural - polyphase merge sort of natural series
+	// radix:<run length> - runs formed in memory, radix-parallel:<run length> - with parallel radix sort
+	std::vector<std::string> sorts = { "natural" };
+	std::size_t repetitions = 1;
+	unsigned long long seed = std::mt19937_64::default_seed;
+	std::string scratch_directory = FileTapeLibrary::DEFAULT_SCRATCH_DIRECTORY;
+	std::string csv_path = "./data/benchmark.csv";
+	std::string json_path = "./data/benchmark.json";
+};
+
+struct RunResult {
+	double wall_seconds = 0;
+	double cpu_seconds = 0;
+	unsigned long long bytes_read = 0;
+	unsigned long long bytes_written = 0;
+	unsigned int phases = 0;
+	unsigned long long page_operations = 0;
+	unsigned long long comparisons = 0;
+	unsigned long long peak_memory = 0;
+	bool sorted = false;
+};
+
+struct Benchmark {
+	unsigned long long records_number;
+	std::string distribution;
+	std::size_t buffer_size;
+	std::string sort;
+	std::vector<RunResult> runs;
+};
+
+// mean and half-width of 95% confidence interval (Student's t distribution)
+std::tuple<double, double> get_confidence_interval(const std::vector<double>& values) {
+	static const double T_95[] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
+
+	auto n = values.size();
+	auto mean = 0.0;
+	for (auto value : values) {
+		mean += value;
+	}
+	mean /= n;
+
+	if (n < 2) {
+		return std::make_tuple(mean, 0.0);
+	}
+
+	auto variance = 0.0;
+	for (auto value : values) {
+		variance += (value - mean) * (value - mean);
+	}
+	variance /= n - 1;
+
+	auto t = n - 1 <= 30 ? T_95[n - 2] : 1.960;
+	return std::make_tuple(mean, t * std::sqrt(variance / n));
+}
+
+RunResult run_sort(const std::string& sort, const std::string& input_path, const std::string& output_path, const std::string& scratch_directory) {
+	typedef FileTapeLibrary::KeySortingPolicy<FileTapeLibrary::MaxKey> policy_type;
+
+	auto result = RunResult();
+	auto policy = FileTapeLibrary::CountingSortingPolicy<policy_type>(policy_type(), result.comparisons);
+
+	reset_peak_memory();
+	auto counters = measure_process();
+	auto start = std::chrono::steady_clock::now();
+
+	if (sort == "natural") {
+		std::tie(result.phases, result.page_operations) = FileTapeLibrary::polyphase_merge_sort(input_path, output_path, policy, scratch_directory);
+	}
+	else if (sort.rfind("radix:", 0) == 0 || sort.rfind("radix-parallel:", 0) == 0) {
+		auto parallel = sort.rfind("radix-parallel:", 0) == 0;
+		auto run_length = std::stoull(sort.substr(sort.find(':') + 1));
+		auto runs_path = scratch_directory + "/runs.dat";
+
+		auto runs_page_operations = FileTapeLibrary::form_runs(input_path, runs_path, FileTapeLibrary::MaxKey(), run_length, parallel);
+		std::tie(result.phases, result.page_operations) = FileTapeLibrary::polyphase_merge_sort(runs_path, output_path, policy, scratch_directory);
+		result.page_operations += runs_page_operations;
+		std::filesystem::remove(runs_path);
+	}
+	else {
+		throw std::exception("Unknown sort");
+	}
+
+	result.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	auto counters_after = measure_process();
+	result.cpu_seconds = counters_after.cpu_seconds - counters.cpu_seconds;
+	result.bytes_read = counters_after.bytes_read - counters.bytes_read;
+	result.bytes_written = counters_after.bytes_written - counters.bytes_written;
+	result.peak_memory = get_peak_memory();
+
+	// checked out of measured time
+	result.sorted = FileTapeLibrary::is_sorted(output_path, policy_type());
+
+	return result;
+}
+
+void write_csv(const std::string& path, const std::vector<Benchmark>& benchmarks) {
+	auto csv = std::ofstream(path, std::ios_base::binary);
+
+	csv << "records,distribution,buffer_size,sort,repetitions,wall_seconds,wall_seconds_ci95,cpu_seconds,cpu_seconds_ci95,"
+		<< "bytes_read,bytes_written,phases,page_operations,comparisons,peak_memory,sorted\n";
+
+	for (const auto& benchmark : benchmarks) {
+		auto wall = std::vector<double>();
+		auto cpu = std::vector<double>();
+		auto sorted = true;
+		for (const auto& run : benchmark.runs) {
+			wall.push_back(run.wall_seconds);
+			cpu.push_back(run.cpu_seconds);
+			sorted = sorted && run.sorted;
+		}
+
+		auto [wall_mean, wall_ci] = get_confidence_interval(wall);
+		auto [cpu_mean, cpu_ci] = get_confidence_interval(cpu);
+		// counts are the same in every repetition - the last one is reported
+		const auto& last = benchmark.runs.back();
+
+		csv << benchmark.records_number << ',' << benchmark.distribution << ',' << benchmark.buffer_size << ',' << benchmark.sort << ','
+			<< benchmark.runs.size() << ',' << wall_mean << ',' << wall_ci << ',' << cpu_mean << ',' << cpu_ci << ','
+			<< last.bytes_read << ',' << last.bytes_written << ',' << last.phases << ',' << last.page_operations << ','
+			<< last.comparisons << ',' << last.peak_memory << ',' << (sorted ? "true" : "false") << '\n';
+	}
+}
+
+void write_json(const std::string& path, const std::vector<Benchmark>& benchmarks) {
+	auto json = std::ofstream(path, std::ios_base::binary);
+
+	json << "[\n";
+	for (std::size_t i = 0; i < benchmarks.size(); ++i) {
+		const auto& benchmark = benchmarks[i];
+
+		auto wall = std::vector<double>();
+		auto cpu = std::vector<double>();
+		for (const auto& run : benchmark.runs) {
+			wall.push_back(run.wall_seconds);
+			cpu.push_back(run.cpu_seconds);
+		}
+		auto [wall_mean, wall_ci] = get_confidence_interval(wall);
+		auto [cpu_mean, cpu_ci] = get_confidence_interval(cpu);
+
+		json << "  {\"records\": " << benchmark.records_number << ", \"distribution\": \"" << benchmark.distribution
+			<< "\", \"buffer_size\": " << benchmark.buffer_size << ", \"sort\": \"" << benchmark.sort << "\",\n"
+			<< "   \"wall_seconds\": {\"mean\": " << wall_mean << ", \"ci95\": " << wall_ci << "},"
+			<< " \"cpu_seconds\": {\"mean\": " << cpu_mean << ", \"ci95\": " << cpu_ci << "},\n"
+			<< "   \"runs\": [";
+
+		for (std::size_t j = 0; j < benchmark.runs.size(); ++j) {
+			const auto& run = benchmark.runs[j];
+			json << (j > 0 ? ", " : "") << "{\"wall_seconds\": " << run.wall_seconds << ", \"cpu_seconds\": " << run.cpu_seconds
+				<< ", \"bytes_read\": " << run.bytes_read << ", \"bytes_written\": " << run.bytes_written
+				<< ", \"phases\": " << run.phases << ", \"page_operations\": " << run.page_operations
+				<< ", \"comparisons\": " << run.comparisons << ", \"peak_memory\": " << run.peak_memory
+				<< ", \"sorted\": " << (run.sorted ? "true" : "false") << "}";
+		}
+
+		json << "]}" << (i + 1 < benchmarks.size() ? "," : "") << "\n";
+	}
+	json << "]\n";
+}
+
+int benchmark(const BenchmarkOptions& options) {
+	std::filesystem::create_directories(options.scratch_directory);
+
+	auto input_path = options.scratch_directory + "/benchmark_input.dat";
+	auto output_path = options.scratch_directory + "/benchmark_sorted.dat";
+	auto benchmarks = std::vector<Benchmark>();
+	auto all_sorted = true;
+
+	for (auto records_number : options.records_numbers) {
+		for (const auto& distribution : options.distributions) {
+			auto generator_options = FileTapeLibrary::GeneratorOptions();
+			generator_options.distribution = DISTRIBUTIONS.at(distribution);
+			generator_options.seed = options.seed;
+			FileTapeLibrary::generate_tape(input_path, records_number, generator_options);
+
+			for (auto buffer_size : options.buffer_sizes) {
+				FileTapeLibrary::BufferedTape::set_buffer_size(buffer_size);
+
+				for (const auto& sort : options.sorts) {
+					auto benchmark = Benchmark{ records_number, distribution, buffer_size, sort, {} };
+
+					for (std::size_t repetition = 0; repetition < options.repetitions; ++repetition) {
+						benchmark.runs.push_back(run_sort(sort, input_path, output_path, options.scratch_directory));
+						all_sorted = all_sorted && benchmark.runs.back().sorted;
+					}
+
+					const auto& last = benchmark.runs.back();
+					std::cout << records_number << " " << distribution << " buffer " << buffer_size << " " << sort << ": "
+						<< last.wall_seconds << " s, " << last.phases << " phases, " << last.page_operations << " disc operations"
+						<< (last.sorted ? "" : " - NOT SORTED") << '\n';
+
+					benchmarks.push_back(std::move(benchmark));
+				}
+			}
+		}
+	}
+
+	FileTapeLibrary::BufferedTape::set_buffer_size(FileTapeLibrary::BufferedTape::DEFAULT_BUFFER_SIZE);
+
+	write_csv(options.csv_path, benchmarks);
+	write_json(options.json_path, benchmarks);
+
+	return all_sorted ? 0 : 1;
+}
+
+// sorts one big tape and checks the result
+// default size is above 2^31 records (over 4 GiB of data), so every counter of sort must be 64-bit
+int stress(unsigned long long records_number) {
+	auto sort_policy = FileTapeLibrary::KeySortingPolicy<FileTapeLibrary::MaxKey>();
+
+	auto filepath = std::string("./data/stress.dat");
+	auto output_path = std::string("./data/stress_sorted.dat");
+
+	std::cout << "generating " << records_number << " records" << std::endl;
+	FileTapeLibrary::initialize_random_tape(filepath, records_number);
+	auto input_size = std::filesystem::file_size(filepath);
+
+	auto start = std::chrono::steady_clock::now();
+	auto [phases, page_operations] = FileTapeLibrary::polyphase_merge_sort(filepath, output_path, sort_policy);
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << input_size << " bytes sorted in " << seconds << " s, " << phases << " phases, " << page_operations << " disc operations" << std::endl;
+
+	if (std::filesystem::file_size(output_path) != input_size) {
+		std::cout << "Sorted file has wrong size" << std::endl;
+		return 1;
+	}
+
+	if (!FileTapeLibrary::is_sorted(output_path, sort_policy)) {
+		std::cout << "File is not sorted" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+// usage: Experiment [options]           - benchmark of sorts, every combination of listed values is run
+//          --records 10,100000          numbers of records
+//          --distributions uniform,zipf uniform, sorted, reverse, nearly-sorted, few-unique, zipf, sawtooth
+//          --buffer-sizes 4096,65536    sizes of tape buffers
+//          --sorts natural,radix:65536  natural, radix:<run length>, radix-parallel:<run length>
+//          --repetitions 5              runs of every combination (for confidence intervals)
+//          --seed 1                     seed of generated tapes
+//          --scratch ./data             directory of input, output and intermediate tapes
+//          --csv ./data/benchmark.csv   summary of every combination
+//          --json ./data/benchmark.json summary and all runs
+//        Experiment stress [records]    - sort of one big tape
 int main(int argc, char** argv) {
-	auto filepath = std::string("./data/random.dat");
-	auto output_path = std::string("./data/sorted.dat");
-	auto data_path = std::string("./data/data.csv");
-	auto data = std::ofstream(data_path, std::ios_base::binary);
+	if (argc >= 2 && std::string(argv[1]) == "stress") {
+		auto records_number = (1ull << 31) + 1;
+		if (argc >= 3) {
+			records_number = std::stoull(argv[2]);
+		}
 
-	auto max_number_of_records = int(100000);
+		return stress(records_number);
+	}
+
+	auto options = BenchmarkOptions();
 
-	for (int i = 10; i <= max_number_of_records; i *= 10) {
-		FileTapeLibrary::initialize_random_tape(filepath, i);
+	try {
+		for (int i = 1; i + 1 < argc; i += 2) {
+			auto name = std::string(argv[i]);
+			auto value = std::string(argv[i + 1]);
 
-		auto numbers = FileTapeLibrary::polyphase_merge_sort(filepath, output_path, sort_policy);
-		
-		if (!FileTapeLibrary::is_sorted(output_path, sort_policy)) {
-			std::cout << "File is not sorted" << std::endl;
+			if (name == "--records") {
+				options.records_numbers.clear();
+				for (const auto& part : split(value, ',')) {
+					options.records_numbers.push_back(static_cast<unsigned long long>(std::stod(part)));
+				}
+			}
+			else if (name == "--distributions") {
+				options.distributions = split(value, ',');
+				for (const auto& distribution : options.distributions) {
+					if (DISTRIBUTIONS.count(distribution) == 0) {
+						throw std::exception("Unknown distribution");
+					}
+				}
+			}
+			else if (name == "--buffer-sizes") {
+				options.buffer_sizes.clear();
+				for (const auto& part : split(value, ',')) {
+					options.buffer_sizes.push_back(std::stoull(part));
+				}
+			}
+			else if (name == "--sorts") {
+				options.sorts = split(value, ',');
+			}
+			else if (name == "--repetitions") {
+				options.repetitions = std::max(1ull, std::stoull(value));
+			}
+			else if (name == "--seed") {
+				options.seed = std::stoull(value);
+			}
+			else if (name == "--scratch") {
+				options.scratch_directory = value;
+			}
+			else if (name == "--csv") {
+				options.csv_path = value;
+			}
+			else if (name == "--json") {
+				options.json_path = value;
+			}
+			else {
+				throw std::exception("Unknown option");
+			}
 		}
 
-		data << i << "," << std::get<0>(numbers) << "," << std::get<1>(numbers) << std::endl;
+		return benchmark(options);
+	}
+	catch (std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return 1;
 	}
 }
@@ -1,52 +1,158 @@
 #pragma once
-#include <fstream>
-#include <string>
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+
+#include "SimdMax.h"
 
 namespace FileTapeLibrary {
-	class ArrayRecord {
+	// record of at most N ints - width is chosen at compile time, so that tapes of narrow data stay small
+	// (record is stored on tapes as raw bytes: 4 bytes of size and N ints)
+	template <std::size_t N>
+	class BasicArrayRecord {
 	public:
-		static const std::size_t MAX_SIZE = 15;
+		static constexpr std::size_t MAX_SIZE = N;
 		// special type of ArrayRecord which size is 0 - used to indicate that it is empty, not existing record
-		static ArrayRecord DNEArrayRecord();
-		
-		ArrayRecord(std::size_t size = MAX_SIZE);
-		ArrayRecord(std::initializer_list<int> list);
-		ArrayRecord(int* data, std::size_t size);
-		/*// copy constructor
-		ArrayRecord(const ArrayRecord& other) = default;
-		// copy assignment
-		ArrayRecord& operator=(const ArrayRecord& other) = default;
-		// move constructor
-		ArrayRecord(ArrayRecord&&) = default;
-		// move assignment
-		ArrayRecord& operator=(ArrayRecord&&) = default;
-		//destructor
-		~ArrayRecord() = default;*/
-		
+		static BasicArrayRecord DNEArrayRecord();
+
+		// records longer than MAX_SIZE are not truncated - constructors throw
+		BasicArrayRecord(std::size_t size = MAX_SIZE);
+		BasicArrayRecord(std::initializer_list<int> list);
+		BasicArrayRecord(const int* data, std::size_t size);
+
 		std::size_t size() const;
-		//void resize(size_t size);
-		//std::string serialize();
-		//void deserialize(std::istream& is);
-		
-		// bool operator<(const ArrayRecord& other) const;
-		// bool operator<=(const ArrayRecord& other) const;
-		// bool operator>(const ArrayRecord& other) const;
-		// bool operator>=(const ArrayRecord& other) const;
-		// bool operator==(const ArrayRecord& other) const;
-		// bool operator!=(const ArrayRecord& other) const;
-		
+
 		int max() const;
-		virtual bool is_valid() const;
+		// keys[i] = records[i].max() for count records - implementation of max is chosen once for all records
+		static void max_keys(const BasicArrayRecord* records, std::size_t count, int* keys);
+		// records are stored on tapes as raw bytes - they must not have virtual functions,
+		// since pointer to virtual table would be written to file and be invalid in other processes
+		bool is_valid() const;
 		std::string short_format() const;
-		
-		// friend std::istream& operator>>(std::istream& is, ArrayRecord& ar);
-		friend std::ostream& operator<<(std::ostream& os, const ArrayRecord& ar);
+
+		// first size() elements are data of the record
+		const int* values() const;
 
 		int& operator[](std::size_t i);
+		const int& operator[](std::size_t i) const;
+
 	private:
-		std::size_t size_;
-		std::array<int, MAX_SIZE> data;
+		std::uint32_t size_;
+		// elements out of size are zeroed - max() reads whole array
+		std::array<int, MAX_SIZE> data = {};
 	};
 
-}
\ No newline at end of file
+	// width used by default
+	typedef BasicArrayRecord<15> ArrayRecord;
+
+	template <std::size_t N>
+	std::ostream& operator<<(std::ostream& os, const BasicArrayRecord<N>& ar);
+
+	template <std::size_t N>
+	BasicArrayRecord<N> BasicArrayRecord<N>::DNEArrayRecord() {
+		return BasicArrayRecord(0);
+	}
+
+	template <std::size_t N>
+	BasicArrayRecord<N>::BasicArrayRecord(std::size_t size) {
+		if (size > MAX_SIZE) {
+			throw std::exception("record is too long");
+		}
+
+		size_ = static_cast<std::uint32_t>(size);
+	}
+
+	template <std::size_t N>
+	BasicArrayRecord<N>::BasicArrayRecord(std::initializer_list<int> list) : BasicArrayRecord(list.begin(), list.size()) {}
+
+	template <std::size_t N>
+	BasicArrayRecord<N>::BasicArrayRecord(const int* data, std::size_t size) : BasicArrayRecord(size) {
+		std::copy(data, data + size, this->data.begin());
+	}
+
+	template <std::size_t N>
+	std::size_t BasicArrayRecord<N>::size() const {
+		return size_;
+	}
+
+	template <std::size_t N>
+	int BasicArrayRecord<N>::max() const {
+		if (size() <= 0) {
+			throw std::exception("record has no data");
+		}
+
+		// vectorized if processor allows it (see SimdMax.h)
+		return simd::max(data.data(), size(), MAX_SIZE);
+	}
+
+	template <std::size_t N>
+	void BasicArrayRecord<N>::max_keys(const BasicArrayRecord* records, std::size_t count, int* keys) {
+		auto max = simd::get_max_function();
+
+		for (std::size_t i = 0; i < count; ++i) {
+			if (records[i].size() <= 0) {
+				throw std::exception("record has no data");
+			}
+
+			keys[i] = max(records[i].data.data(), records[i].size(), MAX_SIZE);
+		}
+	}
+
+	template <std::size_t N>
+	bool BasicArrayRecord<N>::is_valid() const {
+		return size() > 0;
+	}
+
+	template <std::size_t N>
+	std::string BasicArrayRecord<N>::short_format() const {
+		if (is_valid()) {
+			return std::to_string(max());
+		}
+		return "DNE";
+	}
+
+	template <std::size_t N>
+	const int* BasicArrayRecord<N>::values() const {
+		return data.data();
+	}
+
+	template <std::size_t N>
+	int& BasicArrayRecord<N>::operator[](std::size_t i) {
+		return data[i];
+	}
+
+	template <std::size_t N>
+	const int& BasicArrayRecord<N>::operator[](std::size_t i) const {
+		return data[i];
+	}
+
+	template <std::size_t N>
+	std::ostream& operator<<(std::ostream& os, const BasicArrayRecord<N>& ar) {
+		// if record is not valid
+		if (!ar.is_valid()) {
+			os << "DNE";
+			return os;
+		}
+
+		os << "{ ";
+
+		//write data
+		for (std::size_t i = 0; i < ar.size(); ++i) {
+			os << ar[i];
+			if (i != ar.size() - 1) {
+				os << ", ";
+			}
+		}
+
+		os << " }";
+		return os;
+	}
+
+	// widths compiled once, in ArrayRecord.cpp
+	extern template class BasicArrayRecord<4>;
+	extern template class BasicArrayRecord<15>;
+	extern template class BasicArrayRecord<64>;
+}
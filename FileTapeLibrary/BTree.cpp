@@ -1,66 +1,89 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
 #include "BTree.h"
 
-FileTapeLibrary::BTree::BTree(std::string metadata_filepath, std::string index_filepath, std::string records_filepath) {
-	this->metadata_filepath = metadata_filepath;
-	this->index_filepath = index_filepath;
-	this->records_filepath = records_filepath;
+FileTapeLibrary::BTree::BTree(
+	std::string metadata_filepath,
+	std::string index_filepath,
+	std::string records_filepath,
+	std::size_t record_width,
+	std::size_t cache_pages,
+	sync_policy sync,
+	std::size_t page_size
+) : metadata_file(metadata_filepath),
+	index_file(index_filepath),
+	records_file(records_filepath),
+	page_size(read_page_size_from_file(page_size)),
+	record_slot(sizeof(std::uint32_t) + record_width * sizeof(int)),
+	cache(index_file, this->page_size, std::max(cache_pages, MIN_CACHE_PAGES)) {
+	this->record_width = record_width;
+	this->sync = sync;
+
+	// make sure metadata file is big enough to give us root_offset, page size and record width
+	if (metadata_file.get_size() < METADATA_SIZE) {
+		// data of a tree without valid metadata (of older format, or lost) is never discarded
+		if (metadata_file.get_size() != 0 || index_file.get_size() != 0 || records_file.get_size() != 0) {
+			throw std::exception("Unsupported format of tree files - metadata is missing or of old format");
+		}
 
-	// make sure metadata file exists and is big enough to give us root_offset
-	if (!std::filesystem::exists(metadata_filepath) || std::filesystem::file_size(metadata_filepath) < sizeof(root_offset)) {
-		// create empty metadata file
-		initialize_metadata_file();
+		// new tree - all files are created empty
+		clear();
 	}
 	else {
+		// slots of records file are read with the width they were written with
+		check_record_width_in_file();
 		// read root_offset from metadata file
 		read_root_offset_from_file();
 	}
 	
-	// make sure index file exists and is big enough to contain root_page
-	if (!std::filesystem::exists(index_filepath) || std::filesystem::file_size(index_filepath) < root_offset + TreePage::SIZE_IN_FILE) {
-		// file either doesn't exist or is not big enough - create new one
-		initialize_index_file(root_offset);
+	// index file of existing tree must contain root page - it is never recreated, that would discard the tree
+	if (index_file.get_size() < root_offset + this->page_size) {
+		throw std::exception("Corrupt tree files - index file doesn't contain root page");
 	}
 
-	// make sure records file exists
-	if (!std::filesystem::exists(records_filepath)) {
-		// file does not exist - create empty file
-		initialize_records_file();
-	}
+	index_file_end = index_file.get_size();
+	records_file_end = records_file.get_size();
 
 	return;
 }
 
-void FileTapeLibrary::BTree::insert_record(index_t index, ArrayRecord& record) {
+FileTapeLibrary::BTree::~BTree() {
+	// destructor must not throw - errors of the last flush are lost, flush() called before shows them
+	try {
+		flush();
+	}
+	catch (...) {
+	}
+}
+
+void FileTapeLibrary::BTree::insert_record_data(index_t index, const int* data, std::size_t size) {
+	if (size > record_width) {
+		throw std::exception("record is too long");
+	}
+	// NIL_INDEX marks empty keys on pages
+	if (index == NIL_INDEX) {
+		throw std::exception("Wrong index");
+	}
+
+	auto guard = PathGuard(*this);
 	auto position = try_find_record(index);
 
 	// if found
-	if (current_page().get_key(position) == index) {
-		clear_buffer();
+	if (is_found(position, index)) {
 		throw std::exception("Already exists");
 	}
 
-	// if position is empty
-	if (current_page().is_empty_key(position)) {
-		// insert here
-
-		// insert record to records_file
-		auto offset = append_record_to_file(record);
-
-		// insert offset to current page
-		current_page().set_key(position, index);
-		current_page().set_record_offset(position, offset);
-
-		// update page in index_file
-		write_page_to_file(current_page());
-		clear_buffer();
-		
-		return;
-	}
+	// insert record to records_file
+	auto key = index;
+	auto record_offset = append_record_to_file(data, size);
+	// new key of a leaf has no children - keys moved up by splits have the new page on their right
+	auto right_child = NIL_OFFSET;
 
-	/* OVERFLOW */
-	
-	//std::get<>();
-	
 	/*
 	  1. Search for x (using the Searching algorithm).
 	  2. If found, then RETURN (Already_Exists).
@@ -74,14 +97,410 @@ void FileTapeLibrary::BTree::insert_record(index_t index, ArrayRecord& record) {
 	  7. Make the ancestor page the current page.Go to step 3.
 	 */
 
-	
+	while (true) {
+		if (!current_page().is_full()) {
+			current_page().insert_key(position, key, record_offset, right_child);
+			write_page_to_file(current_page());
+			break;
+		}
+
+		/* OVERFLOW */
+
+		if (try_compensation(key, record_offset, right_child)) {
+			break;
+		}
+
+		if (!split(key, record_offset, right_child)) {
+			break;
+		}
+
+		// middle key of split page is inserted to its parent
+		position = current_page().find_position_for_key(key);
+	}
+
+	clear_buffer();
+	end_change();
+}
+
+bool FileTapeLibrary::BTree::try_compensation(index_t key, offset_t record_offset, offset_t right_child) {
+	// root has no siblings
+	if (path.size() < 2) {
+		return false;
+	}
+
+	auto& page = current_page();
+	auto& parent = *path[path.size() - 2];
+	// page is child of parent on this position
+	auto child_position = parent.find_position_for_key(key);
+
+	for (auto left_sibling : { true, false }) {
+		if (left_sibling ? child_position == 0 : child_position == parent.get_keys_count()) {
+			continue;
+		}
+
+		auto& sibling = cache.pin(parent.get_left_child_offset(left_sibling ? child_position - 1 : child_position + 1));
+		if (sibling.is_full()) {
+			cache.unpin(sibling.get_self_offset());
+			continue;
+		}
+
+		// key of parent between the two pages
+		auto separator = left_sibling ? child_position - 1 : child_position;
+		auto& left = left_sibling ? sibling : page;
+		auto& right = left_sibling ? page : sibling;
+
+		auto entries = PageEntries();
+		entries.add_page(left);
+		entries.add_key(parent.get_key(separator), parent.get_record_offset(separator));
+		entries.add_page(right);
+		entries.insert_key(key, record_offset, right_child, page.get_self_offset());
+
+		// keys are spread evenly, middle one goes to parent
+		auto middle = entries.keys.size() / 2;
+		fill_page(left, entries, 0, middle);
+		fill_page(right, entries, middle + 1, entries.keys.size());
+		parent.set_key(separator, entries.keys[middle]);
+		parent.set_record_offset(separator, entries.record_offsets[middle]);
+
+		write_page_to_file(left);
+		write_page_to_file(right);
+		write_page_to_file(parent);
+		cache.unpin(sibling.get_self_offset());
+
+		return true;
+	}
+
+	return false;
+}
+
+bool FileTapeLibrary::BTree::split(index_t& key, offset_t& record_offset, offset_t& right_child) {
+	auto& page = current_page();
+
+	auto entries = PageEntries();
+	entries.add_page(page);
+	entries.insert_key(key, record_offset, right_child, page.get_self_offset());
+
+	// page keeps first d keys, new page gets last d keys
+	auto middle = entries.keys.size() / 2;
+	auto& new_page = cache.pin_new(allocate_page());
+	new_page.set_parent_offset(page.get_parent_offset());
+	fill_page(page, entries, 0, middle);
+	fill_page(new_page, entries, middle + 1, entries.keys.size());
+
+	key = entries.keys[middle];
+	record_offset = entries.record_offsets[middle];
+	right_child = new_page.get_self_offset();
+
+	if (page.is_root()) {
+		// tree grows by a new root with the middle key
+		auto root_page = static_cast<TreePage*>(nullptr);
+		try {
+			root_page = &cache.pin_new(allocate_page());
+		}
+		catch (...) {
+			cache.unpin(new_page.get_self_offset());
+			throw;
+		}
+		auto& root = *root_page;
+		root.set_left_child_offset(0, page.get_self_offset());
+		root.insert_key(0, key, record_offset, right_child);
+
+		page.set_parent_offset(root.get_self_offset());
+		new_page.set_parent_offset(root.get_self_offset());
+
+		write_page_to_file(page);
+		write_page_to_file(new_page);
+		write_page_to_file(root);
+
+		root_offset = root.get_self_offset();
+		write_root_offset_to_file();
+
+		cache.unpin(new_page.get_self_offset());
+		cache.unpin(root.get_self_offset());
+		return false;
+	}
+
+	write_page_to_file(page);
+	write_page_to_file(new_page);
+	cache.unpin(new_page.get_self_offset());
+
+	// parent becomes the current page
+	cache.unpin(page.get_self_offset());
+	path.pop_back();
+	return true;
+}
+
+void FileTapeLibrary::BTree::fill_page(TreePage& page, PageEntries& entries, std::size_t first, std::size_t last) {
+	page.set_entries(entries.keys, entries.record_offsets, entries.children, first, last);
+
+	// children which came from other page point to the new parent
+	for (auto i = first; i <= last; ++i) {
+		if (entries.children[i] != NIL_OFFSET && entries.parents[i] != page.get_self_offset()) {
+			auto& child = cache.pin(entries.children[i]);
+			child.set_parent_offset(page.get_self_offset());
+			write_page_to_file(child);
+			cache.unpin(child.get_self_offset());
+			entries.parents[i] = page.get_self_offset();
+		}
+	}
+}
+
+void FileTapeLibrary::BTree::PageEntries::add_page(TreePage& page) {
+	page.get_entries(keys, record_offsets, children);
+	parents.resize(children.size(), page.get_self_offset());
+}
+
+void FileTapeLibrary::BTree::PageEntries::add_key(index_t key, offset_t record_offset) {
+	keys.push_back(key);
+	record_offsets.push_back(record_offset);
+}
+
+void FileTapeLibrary::BTree::PageEntries::insert_key(index_t key, offset_t record_offset, offset_t right_child, offset_t right_child_parent) {
+	auto position = static_cast<std::size_t>(std::lower_bound(keys.begin(), keys.end(), key) - keys.begin());
+
+	keys.insert(keys.begin() + position, key);
+	record_offsets.insert(record_offsets.begin() + position, record_offset);
+	children.insert(children.begin() + position + 1, right_child);
+	parents.insert(parents.begin() + position + 1, right_child_parent);
+}
+
+FileTapeLibrary::BTree::BulkLoader::BulkLoader(BTree& tree, unsigned long long keys_count, double fill_factor) {
+	if (!(fill_factor > 0.0 && fill_factor <= 1.0)) {
+		throw std::exception("Fill factor must be in (0, 1]");
+	}
+
+	this->tree = &tree;
+	this->keys_count = keys_count;
+
+	// leftovers of a load which didn't finish are overwritten
+	index_path = tree.index_file.get_filepath() + ".bulk";
+	records_path = tree.records_file.get_filepath() + ".bulk";
+	index_file = std::make_unique<RandomAccessFile>(index_path);
+	index_file->truncate();
+	records_file = std::make_unique<RandomAccessFile>(records_path);
+	records_file->truncate();
+
+	auto order = static_cast<unsigned long long>(TreePage::get_order(tree.page_size));
+	auto page_keys = std::clamp(static_cast<unsigned long long>(std::llround(fill_factor * 2 * order)), order, 2 * order);
+
+	// pages of a level are separated by keys moved up - level above has one key less than pages of the level below
+	auto level_keys = keys_count;
+	auto offset = offset_t(0);
+	while (true) {
+		// as few pages as fill factor allows, but not so many that some would have less than d keys
+		auto pages_count = std::max(1ull, std::min((level_keys + page_keys + 1) / (page_keys + 1), (level_keys + 1) / (order + 1)));
+		auto kept_keys = level_keys - (pages_count - 1);
+
+		levels.push_back(Level{
+			level_keys,
+			pages_count,
+			offset,
+			kept_keys / pages_count,
+			kept_keys % pages_count,
+			0,
+			0,
+			TreePage(offset, tree.page_size)
+		});
+		offset += pages_count * tree.page_size;
+
+		if (pages_count == 1) {
+			break;
+		}
+		level_keys = pages_count - 1;
+	}
+
+	for (auto level = std::size_t(0); level < levels.size(); ++level) {
+		start_page(level, 0);
+	}
+
+	records_buffer.reserve(RECORDS_BUFFER_SIZE + tree.record_slot.size());
+}
+
+FileTapeLibrary::BTree::BulkLoader::~BulkLoader() {
+	if (finished) {
+		return;
+	}
+
+	// files are closed before they are removed
+	index_file.reset();
+	records_file.reset();
+
+	auto error = std::error_code();
+	std::filesystem::remove(index_path, error);
+	std::filesystem::remove(records_path, error);
+}
+
+void FileTapeLibrary::BTree::BulkLoader::add(index_t key, const int* data, std::size_t size) {
+	if (size > tree->record_width) {
+		throw std::exception("record is too long");
+	}
+	if (key == NIL_INDEX) {
+		throw std::exception("Wrong index");
+	}
+	if (keys_added > 0 && key <= last_key) {
+		throw std::exception("Keys of bulk loaded records must be increasing");
+	}
+	if (keys_added == keys_count) {
+		throw std::exception("More records than expected");
+	}
+
+	// record slot is appended to the buffer - the same layout as write_record_to_file
+	auto record_offset = records_buffer_offset + records_buffer.size();
+	auto slot = records_buffer.size();
+	auto stored_size = static_cast<std::uint32_t>(size);
+	records_buffer.resize(slot + tree->record_slot.size());
+	std::memcpy(records_buffer.data() + slot, &stored_size, sizeof(stored_size));
+	std::memcpy(records_buffer.data() + slot + sizeof(stored_size), data, size * sizeof(int));
+
+	if (records_buffer.size() >= RECORDS_BUFFER_SIZE) {
+		flush_records();
+	}
+
+	// key goes to the lowest level whose page has room - it is the in-order successor of keys added before
+	auto level = std::size_t(0);
+	while (true) {
+		auto& current = levels[level];
+		auto position = current.page.get_keys_count();
+
+		if (position < get_page_keys(current, current.page_index)) {
+			if (position == 0) {
+				current.page.set_left_child_offset(0, get_child_offset(level, current.keys_routed));
+			}
+			current.page.insert_key(position, key, record_offset, get_child_offset(level, current.keys_routed + 1));
+			++current.keys_routed;
+			break;
+		}
+
+		// page is complete - key separates it from the next page of the level, so it is moved up
+		current.page.write_to_file(*index_file);
+		++current.keys_routed;
+		start_page(level, current.page_index + 1);
+		++level;
+	}
+
+	++keys_added;
+	last_key = key;
+}
+
+void FileTapeLibrary::BTree::BulkLoader::finish() {
+	if (keys_added != keys_count) {
+		throw std::exception("Fewer records than expected");
+	}
+
+	// last page of every level is complete now
+	for (auto& level : levels) {
+		level.page.write_to_file(*index_file);
+	}
+	flush_records();
+
+	if (tree->sync != sync_policy::none) {
+		index_file->sync();
+		records_file->sync();
+	}
+	index_file.reset();
+	records_file.reset();
+
+	// pages of the old tree are written and forgotten before its files are moved away
+	tree->cache.flush();
+	tree->cache.clear();
+
+	/*
+	 * old files are moved aside, so the index can be moved back if records can't be replaced -
+	 * if either replacement fails, the old tree stays current (unless moving a file back fails too,
+	 * then it is left in its .old file)
+	 */
+	auto old_index_path = tree->index_file.get_filepath() + ".old";
+	auto old_records_path = tree->records_file.get_filepath() + ".old";
+	tree->index_file.replace_with(index_path, old_index_path);
+	try {
+		tree->records_file.replace_with(records_path, old_records_path);
+	}
+	catch (...) {
+		tree->index_file.replace_with(old_index_path);
+		throw;
+	}
+	finished = true;
+
+	auto error = std::error_code();
+	std::filesystem::remove(old_index_path, error);
+	std::filesystem::remove(old_records_path, error);
+
+	tree->root_offset = levels.back().first_page_offset;
+	tree->write_root_offset_to_file();
+	tree->index_file_end = levels.back().first_page_offset + tree->page_size;
+	tree->records_file_end = records_buffer_offset;
+
+	tree->end_change();
+}
+
+unsigned long long FileTapeLibrary::BTree::BulkLoader::get_page_keys(const Level& level, unsigned long long page_index) const {
+	return level.base_keys + (page_index < level.extra_keys ? 1 : 0);
+}
+
+unsigned long long FileTapeLibrary::BTree::BulkLoader::get_page_of_child(const Level& level, unsigned long long child_index) const {
+	// page with k keys has k + 1 children
+	auto bigger_pages_children = level.extra_keys * (level.base_keys + 2);
+
+	if (child_index < bigger_pages_children) {
+		return child_index / (level.base_keys + 2);
+	}
+	return level.extra_keys + (child_index - bigger_pages_children) / (level.base_keys + 1);
+}
+
+FileTapeLibrary::offset_t FileTapeLibrary::BTree::BulkLoader::get_child_offset(std::size_t level, unsigned long long child_index) const {
+	if (level == 0) {
+		return NIL_OFFSET;
+	}
+	return levels[level - 1].first_page_offset + child_index * tree->page_size;
+}
+
+void FileTapeLibrary::BTree::BulkLoader::start_page(std::size_t level, unsigned long long page_index) {
+	auto& current = levels[level];
+	current.page_index = page_index;
+	current.page = TreePage(current.first_page_offset + page_index * tree->page_size, tree->page_size);
+
+	if (level + 1 < levels.size()) {
+		auto& parent = levels[level + 1];
+		current.page.set_parent_offset(parent.first_page_offset + get_page_of_child(parent, page_index) * tree->page_size);
+	}
+}
+
+void FileTapeLibrary::BTree::BulkLoader::flush_records() {
+	if (records_buffer.empty()) {
+		return;
+	}
+
+	records_file->write_at(records_buffer_offset, records_buffer.data(), records_buffer.size());
+	records_buffer_offset += records_buffer.size();
+	records_buffer.clear();
 }
 
-FileTapeLibrary::ArrayRecord FileTapeLibrary::BTree::read_record(index_t index) {
+void FileTapeLibrary::BTree::update_record_data(index_t index, const int* data, std::size_t size) {
+	if (size > record_width) {
+		throw std::exception("record is too long");
+	}
+
+	auto guard = PathGuard(*this);
+	auto position = try_find_record(index);
+
+	// if not found
+	if (!is_found(position, index)) {
+		throw std::exception("Not found");
+	}
+
+	// slots have the same size, so record is replaced in place
+	auto record_offset = current_page().get_record_offset(position);
+	clear_buffer();
+	write_record_to_file(record_offset, data, size);
+	end_change();
+}
+
+std::vector<int> FileTapeLibrary::BTree::read_record_data(index_t index) {
+	auto guard = PathGuard(*this);
 	auto position = try_find_record(index);
 
 	// if found
-	if (page_buffer.back().get_key(position) == index) {
+	if (is_found(position, index)) {
 		// read record from file
 		auto record_offset = current_page().get_record_offset(position);
 		// clear buffer
@@ -89,47 +508,253 @@ FileTapeLibrary::ArrayRecord FileTapeLibrary::BTree::read_record(index_t index)
 		// return record
 		return read_record_from_file(record_offset);
 	}
-	
-	clear_buffer();
+
 	throw std::exception("Not found");
 }
 
+FileTapeLibrary::BTree::Cursor FileTapeLibrary::BTree::scan(index_t lo, index_t hi, std::size_t batch_size) {
+	return Cursor(*this, lo, hi, batch_size);
+}
+
 void FileTapeLibrary::BTree::print_file() {
+	print_file(std::cout);
+}
+
+void FileTapeLibrary::BTree::print_file(std::ostream& logger) {
+	logger << "root: " << root_offset << ", page size: " << page_size << ", order: " << TreePage::get_order(page_size) << std::endl;
+	print_page(logger, root_offset, 0);
+
+	auto cursor = scan();
+	while (!cursor.is_empty()) {
+		// records of any width up to record_width are printed
+		auto entry = cursor.next_entry();
+		logger << cursor.get_current_key() << ": { ";
+		for (std::size_t i = 0; i < cursor.sizes[entry]; ++i) {
+			logger << cursor.records[entry * record_width + i] << " ";
+		}
+		logger << "}" << std::endl;
+	}
+}
+
+void FileTapeLibrary::BTree::print_page(std::ostream& logger, offset_t offset, std::size_t depth) {
+	// page is copied, so that printing doesn't keep the whole path pinned
+	auto& pinned = cache.pin(offset);
+	auto page = pinned;
+	cache.unpin(offset);
+
+	logger << std::string(2 * depth, ' ') << "page " << offset << ":";
+	for (std::size_t position = 0; position < page.get_keys_count(); ++position) {
+		logger << " " << page.get_key(position);
+	}
+	logger << std::endl;
+
+	if (!page.is_leaf()) {
+		for (std::size_t position = 0; position <= page.get_keys_count(); ++position) {
+			print_page(logger, page.get_left_child_offset(position), depth + 1);
+		}
+	}
+}
+
+FileTapeLibrary::BTree::Cursor::Cursor(BTree& tree, index_t lo, index_t hi, std::size_t batch_size) {
+	if (batch_size == 0) {
+		throw std::exception("Batch size must be positive");
+	}
+
+	this->tree = &tree;
+	this->hi = hi;
+	this->batch_size = batch_size;
+	record_width = tree.record_width;
+
+	if (lo < hi) {
+		descend(tree.root_offset, lo);
+	}
+}
+
+bool FileTapeLibrary::BTree::Cursor::is_empty() {
+	if (next == keys.size()) {
+		fill_batch();
+	}
+
+	return next == keys.size();
+}
+
+FileTapeLibrary::index_t FileTapeLibrary::BTree::Cursor::get_current_key() const {
+	return current_key;
+}
+
+void FileTapeLibrary::BTree::Cursor::descend(offset_t offset, index_t key) {
+	while (true) {
+		// pages are copied - cursor doesn't hold pins between calls
+		auto& page = tree->cache.pin(offset);
+		path.push_back(Frame{ page, page.find_position_for_key(key) });
+		tree->cache.unpin(offset);
+
+		auto& frame = path.back();
+		if (frame.page.is_leaf()) {
+			break;
+		}
+		offset = frame.page.get_left_child_offset(frame.position);
+	}
+}
+
+bool FileTapeLibrary::BTree::Cursor::advance(index_t& key, offset_t& record_offset) {
+	while (!path.empty()) {
+		auto& frame = path.back();
+
+		// subtree of the page is done - its parent has the next key
+		if (frame.position == frame.page.get_keys_count()) {
+			path.pop_back();
+			continue;
+		}
+
+		key = frame.page.get_key(frame.position);
+		record_offset = frame.page.get_record_offset(frame.position);
+		++frame.position;
+
+		if (key >= hi) {
+			path.clear();
+			return false;
+		}
+
+		// keys of right child of inner key come next
+		if (!frame.page.is_leaf()) {
+			descend(frame.page.get_left_child_offset(frame.position), 0);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+void FileTapeLibrary::BTree::Cursor::fill_batch() {
+	keys.clear();
+	record_offsets.clear();
+	next = 0;
+
+	auto key = index_t();
+	auto record_offset = offset_t();
+	while (keys.size() < batch_size && advance(key, record_offset)) {
+		keys.push_back(key);
+		record_offsets.push_back(record_offset);
+	}
+
+	auto count = keys.size();
+	auto slot_size = tree->record_slot.size();
+	records.resize(count * record_width);
+	sizes.resize(count);
+
+	// records are read in order of offsets - slots next to each other (e.g. of bulk loaded tree) are read with one call
+	order.resize(count);
+	std::iota(order.begin(), order.end(), std::size_t(0));
+	std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return record_offsets[a] < record_offsets[b]; });
+
+	for (std::size_t first = 0, last = 0; first < count; first = last) {
+		last = first + 1;
+		while (last < count && record_offsets[order[last]] == record_offsets[order[last - 1]] + slot_size) {
+			++last;
+		}
+
+		slots.resize((last - first) * slot_size);
+		if (tree->records_file.read_at(record_offsets[order[first]], slots.data(), slots.size()) != slots.size()) {
+			throw std::exception("Record is beyond end of records file");
+		}
+
+		for (auto i = first; i < last; ++i) {
+			auto slot = slots.data() + (i - first) * slot_size;
+			auto entry = order[i];
+			std::memcpy(&sizes[entry], slot, sizeof(std::uint32_t));
+			std::memcpy(records.data() + entry * record_width, slot + sizeof(std::uint32_t), record_width * sizeof(int));
+		}
+	}
+}
+
+std::size_t FileTapeLibrary::BTree::Cursor::next_entry() {
+	if (is_empty()) {
+		throw std::exception("Cursor is empty");
+	}
+
+	current_key = keys[next];
+	return next++;
+}
+
+std::size_t FileTapeLibrary::BTree::get_record_width() const {
+	return record_width;
+}
+
+std::size_t FileTapeLibrary::BTree::get_page_size() const {
+	return page_size;
+}
+
+unsigned long long FileTapeLibrary::BTree::get_page_reads() const {
+	return cache.get_page_reads();
+}
+
+unsigned long long FileTapeLibrary::BTree::get_page_writes() const {
+	return cache.get_page_writes();
+}
+
+unsigned long long FileTapeLibrary::BTree::get_cache_hits() const {
+	return cache.get_hits();
+}
+
+unsigned long long FileTapeLibrary::BTree::get_cache_misses() const {
+	return cache.get_misses();
 }
 
 FileTapeLibrary::TreePage& FileTapeLibrary::BTree::current_page() {
-	return page_buffer.back();
+	return *path.back();
 }
 
 void FileTapeLibrary::BTree::clear_buffer() {
-	page_buffer.clear();
+	for (auto page : path) {
+		cache.unpin(page->get_self_offset());
+	}
+	path.clear();
+}
+
+FileTapeLibrary::BTree::PathGuard::PathGuard(BTree& tree) : tree(tree) {
+	assert(tree.path.empty());
+	// pages left by an operation which didn't end must never become the path of the next one
+	tree.clear_buffer();
+}
+
+FileTapeLibrary::BTree::PathGuard::~PathGuard() {
+	tree.clear_buffer();
 }
 
 void FileTapeLibrary::BTree::initialize_metadata_file(offset_t root_offset) {
-	// file create empty file
-	auto index_file = std::fstream(metadata_filepath, std::ios::out | std::ios::trunc);
-	index_file.close();
+	// discard current content
+	metadata_file.truncate();
 
 	// put default root page in a file
 	this->root_offset = root_offset;
 	// put root_offset in file
-	write_root_offset_to_file();		
+	write_root_offset_to_file();
+
+	auto stored_page_size = static_cast<std::uint64_t>(page_size);
+	metadata_file.write_at(PAGE_SIZE_OFFSET, reinterpret_cast<const char*>(&stored_page_size), sizeof(stored_page_size));
+
+	auto stored_record_width = static_cast<std::uint64_t>(record_width);
+	metadata_file.write_at(RECORD_WIDTH_OFFSET, reinterpret_cast<const char*>(&stored_record_width), sizeof(stored_record_width));
 }
 
 void FileTapeLibrary::BTree::initialize_index_file(offset_t root_offset) {
-	// discard current content in file or create empty
-	auto index_file = std::fstream(index_filepath, std::ios::out | std::ios::trunc);
-	index_file.close();
+	// discard current content
+	index_file.truncate();
+
+	// pages of previous content are forgotten
+	cache.clear();
 
 	// put empty root page in file
-	page_buffer.emplace_back(TreePage(root_offset));
-	write_page_to_file(current_page());
-	clear_buffer();
+	auto root = TreePage(root_offset, page_size);
+	root.write_to_file(index_file);
+
+	index_file_end = root_offset + page_size;
 }
 
 void FileTapeLibrary::BTree::initialize_records_file() {
-	auto records_file = std::fstream(records_filepath, std::ios::out | std::ios::trunc);
-	records_file.close();
+	records_file.truncate();
+	records_file_end = 0;
 }
 
 void FileTapeLibrary::BTree::clear() {
@@ -138,6 +763,22 @@ void FileTapeLibrary::BTree::clear() {
 	initialize_records_file();
 }
 
+void FileTapeLibrary::BTree::flush() {
+	cache.flush();
+
+	if (sync != sync_policy::none) {
+		records_file.sync();
+		index_file.sync();
+		metadata_file.sync();
+	}
+}
+
+void FileTapeLibrary::BTree::end_change() {
+	if (sync == sync_policy::every_operation) {
+		flush();
+	}
+}
+
 std::size_t FileTapeLibrary::BTree::try_find_record(index_t index) {
 	auto s = root_offset;
 	auto position = std::size_t();
@@ -153,96 +794,105 @@ std::size_t FileTapeLibrary::BTree::try_find_record(index_t index) {
 	  8. Let s = pi, where xi < x < xi+1. Go to step 2.
 	 */
 	
-	do {
+	while (true) {
 		read_page_from_file(s);
 
-		// find_position_for_key position for next item
 		position = current_page().find_position_for_key(index);
 
-		// if either is empty or the one we looking for
-		if (current_page().is_empty_key(position) || current_page().get_key(position) == index) {
-			// found
+		if (is_found(position, index)) {
 			break;
 		}
 
-		if (current_page().get_key(position) < index) {
-			s = current_page().get_left_child_offset(position);
-		}
-		else if (current_page().get_key(position) > index) {
-			s = current_page().get_right_child_offset(position);
+		// keys[position - 1] < index < keys[position] - index can only be in the child between them
+		s = current_page().get_left_child_offset(position);
+
+		// leaf - index belongs to position
+		if (s == NIL_OFFSET) {
+			break;
 		}
 	}
-	while (s != NIL_OFFSET);
 	
 	return position;
 }
 
+bool FileTapeLibrary::BTree::is_found(std::size_t position, index_t index) {
+	return position < current_page().get_keys_count() && current_page().get_key(position) == index;
+}
+
 void FileTapeLibrary::BTree::read_page_from_file(offset_t offset) {
-	page_buffer.emplace_back(TreePage(offset));
-	current_page().read_from_file(index_filepath);
+	path.push_back(&cache.pin(offset));
 }
 
 void FileTapeLibrary::BTree::write_page_to_file(TreePage& page) {
-	page.write_to_file(index_filepath);
+	cache.mark_dirty(page.get_self_offset());
+}
+
+FileTapeLibrary::offset_t FileTapeLibrary::BTree::allocate_page() {
+	auto offset = index_file_end;
+	index_file_end += page_size;
+
+	return offset;
 }
 
 void FileTapeLibrary::BTree::read_root_offset_from_file() {
-	auto index_file = std::ifstream(metadata_filepath, std::ios::binary | std::ios::out | std::ios::in);
-	index_file.seekg(ROOT_OFFSET_OFFSET);
-	index_file.read(reinterpret_cast<char*>(&root_offset), sizeof(root_offset));
-	index_file.close();
+	metadata_file.read_at(ROOT_OFFSET_OFFSET, reinterpret_cast<char*>(&root_offset), sizeof(root_offset));
 }
 
 void FileTapeLibrary::BTree::write_root_offset_to_file() {
-	auto index_file = std::ofstream(metadata_filepath, std::ios::binary | std::ios::out | std::ios::in);
-	index_file.seekp(ROOT_OFFSET_OFFSET);
-	index_file.write(reinterpret_cast<const char*>(&root_offset), sizeof(root_offset));
-	index_file.close();
+	metadata_file.write_at(ROOT_OFFSET_OFFSET, reinterpret_cast<const char*>(&root_offset), sizeof(root_offset));
 }
 
-FileTapeLibrary::ArrayRecord FileTapeLibrary::BTree::read_record_from_file(offset_t offset) {
-	auto records_file = std::ifstream(records_filepath, std::ios::binary | std::ios::out | std::ios::in);
-	records_file.seekg(offset);
+std::size_t FileTapeLibrary::BTree::read_page_size_from_file(std::size_t default_page_size) {
+	auto stored_page_size = static_cast<std::uint64_t>(default_page_size);
 
-	auto size = std::size_t();
-	records_file.read(reinterpret_cast<char*>(&size), sizeof(size));
-	auto record = ArrayRecord(size);
-
-	for (std::size_t i = 0; i < ArrayRecord::MAX_SIZE; i++) {
-		records_file.read(reinterpret_cast<char*>(&record[i]), sizeof(record[i]));
+	if (metadata_file.get_size() >= METADATA_SIZE) {
+		metadata_file.read_at(PAGE_SIZE_OFFSET, reinterpret_cast<char*>(&stored_page_size), sizeof(stored_page_size));
 	}
-	
-	records_file.close();
-	
-	return record;
+
+	// checks the size
+	TreePage::get_order(static_cast<std::size_t>(stored_page_size));
+
+	return static_cast<std::size_t>(stored_page_size);
 }
 
-void FileTapeLibrary::BTree::write_record_to_file(offset_t offset, ArrayRecord& record) {
-	auto records_file = std::ofstream(records_filepath, std::ios::binary | std::ios::out | std::ios::in);
-	records_file.seekp(offset);
-	
-	auto size = record.size();
-	records_file.write(reinterpret_cast<char*>(&size), sizeof(size));
+void FileTapeLibrary::BTree::check_record_width_in_file() {
+	auto stored_record_width = std::uint64_t();
+	metadata_file.read_at(RECORD_WIDTH_OFFSET, reinterpret_cast<char*>(&stored_record_width), sizeof(stored_record_width));
+
+	if (stored_record_width != record_width) {
+		throw std::exception("Record width differs from record width of the tree");
+	}
+}
 
-	for (int i = 0; i < ArrayRecord::MAX_SIZE; ++i) {
-		records_file.write(reinterpret_cast<const char*>(&record[i]), sizeof(record[i]));
+std::vector<int> FileTapeLibrary::BTree::read_record_from_file(offset_t offset) {
+	// whole slot is read at once, then cut to size of the record
+	if (records_file.read_at(offset, record_slot.data(), record_slot.size()) != record_slot.size()) {
+		throw std::exception("Record is beyond end of records file");
 	}
 
-	records_file.close();
+	auto size = std::uint32_t();
+	std::memcpy(&size, record_slot.data(), sizeof(size));
+
+	auto record = std::vector<int>(std::min<std::size_t>(size, record_width));
+	std::memcpy(record.data(), record_slot.data() + sizeof(size), record.size() * sizeof(int));
+
+	return record;
 }
 
-FileTapeLibrary::offset_t FileTapeLibrary::BTree::append_record_to_file(ArrayRecord& record) {
-	auto records_file = std::ofstream(records_filepath, std::ios::binary | std::ios::out | std::ios::in | std::ios::ate);
+void FileTapeLibrary::BTree::write_record_to_file(offset_t offset, const int* data, std::size_t size) {
+	// slot of record has always record_width ints
+	auto stored_size = static_cast<std::uint32_t>(size);
+	std::memcpy(record_slot.data(), &stored_size, sizeof(stored_size));
+	std::memcpy(record_slot.data() + sizeof(stored_size), data, size * sizeof(int));
+	std::fill(record_slot.begin() + sizeof(stored_size) + size * sizeof(int), record_slot.end(), 0);
+
+	records_file.write_at(offset, record_slot.data(), record_slot.size());
+}
 
-	auto offset = records_file.tellp();
-	auto size = record.size();
-	records_file.write(reinterpret_cast<char*>(&size), sizeof(size));
+FileTapeLibrary::offset_t FileTapeLibrary::BTree::append_record_to_file(const int* data, std::size_t size) {
+	auto offset = records_file_end;
+	write_record_to_file(offset, data, size);
+	records_file_end += record_slot.size();
 
-	for (std::size_t i = 0; i < ArrayRecord::MAX_SIZE; ++i) {
-		records_file.write(reinterpret_cast<const char*>(&record[i]), sizeof(record[i]));
-	}
-	
-	records_file.close();
-	
 	return offset;
 }
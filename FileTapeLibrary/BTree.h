@@ -1,66 +1,342 @@
 #pragma once
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <ostream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "typedefs.h"
 #include "ArrayRecord.h"
+#include "BufferPool.h"
+#include "PageCache.h"
+#include "RandomAccessFile.h"
+#include "SortingPolicy.h"
+#include "Tape.h"
 #include "TreePage.h"
 
 namespace FileTapeLibrary {
+	// when changes of the tree are forced to the device
+	enum class sync_policy {
+		// never - system writes data when it wants
+		none,
+		// on flush() and when the tree is destroyed
+		on_flush,
+		// every insert and update writes its pages and syncs files before it returns
+		every_operation
+	};
+
 	class BTree {
 	public:
 		// storing root_offset in metadata file to be able to tell where the root is in file
 		// we must keep offset pointing to root_offset in metadata file
 		static constexpr offset_t ROOT_OFFSET_OFFSET = 0;
+		// size of pages of index file (8 bytes) follows root_offset
+		static constexpr offset_t PAGE_SIZE_OFFSET = ROOT_OFFSET_OFFSET + sizeof(offset_t);
+		// width of record slots (8 bytes) follows page size
+		static constexpr offset_t RECORD_WIDTH_OFFSET = PAGE_SIZE_OFFSET + sizeof(std::uint64_t);
+		static constexpr offset_t METADATA_SIZE = RECORD_WIDTH_OFFSET + sizeof(std::uint64_t);
 		static constexpr offset_t DEFAULT_ROOT_OFFSET = 0;
+		// insert pins the whole path from root and a few more pages - smaller caches are raised to this size
+		static constexpr std::size_t MIN_CACHE_PAGES = 32;
 		
-		BTree(std::string metadata_filepath, std::string index_filepath, std::string records_filepath);
+		// records file keeps records of at most record_width ints - width is stored in metadata file,
+		// opening existing tree with another width throws
+		// cache_pages pages of index file are kept in memory - changed pages are written back on eviction, flush or destruction
+		// files are held open until the tree is destroyed
+		// page_size (e.g. 4, 8 or 16 KiB) sets order of the tree - existing tree keeps page size stored in its metadata file
+		BTree(
+			std::string metadata_filepath,
+			std::string index_filepath,
+			std::string records_filepath,
+			std::size_t record_width = ArrayRecord::MAX_SIZE,
+			std::size_t cache_pages = PageCache::DEFAULT_CAPACITY,
+			sync_policy sync = sync_policy::on_flush,
+			std::size_t page_size = TreePage::DEFAULT_SIZE
+		);
+		// flushes the tree, ignoring errors - call flush() first to see them
+		~BTree();
+
+		// records of any width up to record_width (BasicArrayRecord<N>) can be stored
+		template <typename Record = ArrayRecord>
+		void insert_record(index_t index, const Record& record) {
+			insert_record_data(index, record.values(), record.size());
+		}
+
+		// replaces record of existing index - its slot in records file is overwritten
+		template <typename Record = ArrayRecord>
+		void update_record(index_t index, const Record& record) {
+			update_record_data(index, record.values(), record.size());
+		}
+
+		template <typename Record = ArrayRecord>
+		Record read_record(index_t index) {
+			auto data = read_record_data(index);
+			return Record(data.data(), data.size());
+		}
+
+		// replaces content of the tree with records of a tape sorted by key_extractor - MaxKey by default,
+		// like default polyphase_merge_sort, so its output can be loaded as it is
+		// keys must be distinct - records file is written in one sequential pass and index is built bottom-up,
+		// pages are filled to fill_factor of their capacity (but never below half of it)
+		template <typename Record = ArrayRecord, typename KeyExtractor = MaxKey>
+		void bulk_load(std::string sorted_input_path, const KeyExtractor& key_extractor = KeyExtractor(), double fill_factor = 1.0) {
+			auto records_count = static_cast<unsigned long long>(std::filesystem::file_size(sorted_input_path) / sizeof(Record));
+			auto input = BasicTape<Record>(sorted_input_path, BufferedTape::read);
+
+			auto loader = BulkLoader(*this, records_count, fill_factor);
+			while (!input.is_empty()) {
+				const auto& record = input.read_next_record();
+				auto key = key_extractor(record);
+				if constexpr (std::is_signed_v<decltype(key)>) {
+					if (key < 0) {
+						throw std::exception("Negative key");
+					}
+				}
+				loader.add(static_cast<index_t>(key), record.values(), record.size());
+			}
+			loader.finish();
+		}
+
+		/*
+		 * forward cursor over records with keys in [lo, hi), in order of keys
+		 * path from root is kept in the cursor, so every page of the range is read once (and the leftmost path
+		 * of the next subtree as soon as a key of an inner page is passed)
+		 * records are read ahead in batches - in order of their offsets, neighbouring slots with one call
+		 * cursor is valid until the tree is changed
+		 */
+		class Cursor {
+		public:
+			static constexpr std::size_t DEFAULT_BATCH_SIZE = 256;
+
+			Cursor(BTree& tree, index_t lo, index_t hi, std::size_t batch_size);
+
+			// check if all records of the range were read
+			bool is_empty();
 
-		void insert_record(index_t index, ArrayRecord& record);
-		ArrayRecord read_record(index_t index);
+			template <typename Record = ArrayRecord>
+			Record read_next_record() {
+				auto entry = next_entry();
+				return Record(records.data() + entry * record_width, sizes[entry]);
+			}
+			// key of record returned by last read_next_record
+			index_t get_current_key() const;
+
+		private:
+			friend class BTree;
+
+			struct Frame {
+				TreePage page;
+				// next key of page to be returned
+				std::size_t position;
+			};
+
+			BTree* tree;
+			index_t hi;
+			std::size_t batch_size;
+			std::size_t record_width;
+			std::vector<Frame> path;
+
+			// current batch - keys and records in order of keys
+			std::vector<index_t> keys;
+			std::vector<offset_t> record_offsets;
+			std::vector<int> records;
+			std::vector<std::uint32_t> sizes;
+			std::size_t next = 0;
+			index_t current_key = NIL_INDEX;
+			// entries of batch in order of offsets and slots read with one call
+			std::vector<std::size_t> order;
+			std::vector<char> slots;
+
+			// pushes pages from given one down to a leaf - on every page the first key not smaller than key is next
+			void descend(offset_t offset, index_t key);
+			// next key of the range in order
+			bool advance(index_t& key, offset_t& record_offset);
+			void fill_batch();
+			std::size_t next_entry();
+		};
+
+		// records with keys lo <= key < hi
+		Cursor scan(index_t lo = 0, index_t hi = NIL_INDEX, std::size_t batch_size = Cursor::DEFAULT_BATCH_SIZE);
+
+		// pages of index (from root, inner pages indented) followed by records in order of keys
 		void print_file();
+		void print_file(std::ostream& logger);
 		// clear database
 		void clear();
+		// writes changed pages of cache to index file (and syncs files, unless sync policy is none)
+		// throws on failed write or sync
+		void flush();
 		
+		std::size_t get_record_width() const;
+		std::size_t get_page_size() const;
+
+		// pages read from and written to index file since the tree was opened
+		unsigned long long get_page_reads() const;
+		unsigned long long get_page_writes() const;
+		// pages found in cache and read from file
+		unsigned long long get_cache_hits() const;
+		unsigned long long get_cache_misses() const;
+
 	private:
+		void insert_record_data(index_t index, const int* data, std::size_t size);
+		void update_record_data(index_t index, const int* data, std::size_t size);
+		std::vector<int> read_record_data(index_t index);
+		void print_page(std::ostream& logger, offset_t offset, std::size_t depth);
+
+		std::size_t record_width;
+		sync_policy sync;
 		offset_t root_offset;
-		std::vector<TreePage> page_buffer;
+
+		// files are declared before cache, which writes to index_file
+		RandomAccessFile metadata_file;
+		RandomAccessFile index_file;
+		RandomAccessFile records_file;
+		std::size_t page_size;
+		// new pages and records are appended here
+		offset_t index_file_end = 0;
+		offset_t records_file_end = 0;
+		// size and ints of one record - written and read with one call
+		std::vector<char> record_slot;
+
+		PageCache cache;
+		// pages on path from root - they are pinned in cache until the operation ends
+		std::vector<TreePage*> path;
 
 		TreePage& current_page();
 		void clear_buffer();
+
+		// path is empty when operation starts and its pages are unpinned when operation ends, also when it throws
+		class PathGuard {
+		public:
+			PathGuard(BTree& tree);
+			PathGuard(const PathGuard&) = delete;
+			PathGuard& operator=(const PathGuard&) = delete;
+			~PathGuard();
+
+		private:
+			BTree& tree;
+		};
 		//TreePage* last_read_page;
 
+		// called after insert and update
+		void end_change();
+
 		// init empty files
 		void initialize_metadata_file(offset_t root_offset = DEFAULT_ROOT_OFFSET);
 		void initialize_index_file(offset_t root_offset = DEFAULT_ROOT_OFFSET);
 		void initialize_records_file();
 
 		// finds a place for given index in a file
-		// leaves current page as last in the buffer
-		// returns position of index on page
-		// to check if found successfully check if page_buffer.back()[position] == index
+		// leaves pages on path from root in the buffer, current page as last
+		// returns position of index on page (where it is or where it should be inserted in a leaf)
+		// to check if found successfully use is_found(position, index)
 		std::size_t try_find_record(index_t index);
+		bool is_found(std::size_t position, index_t index);
+
+		// entries of pages taking part in compensation or split - children[i] is left child of keys[i]
+		// parents[i] is the page children[i] is written with, so that only moved children are rewritten
+		struct PageEntries {
+			std::vector<index_t> keys;
+			std::vector<offset_t> record_offsets;
+			std::vector<offset_t> children;
+			std::vector<offset_t> parents;
+
+			void add_page(TreePage& page);
+			void add_key(index_t key, offset_t record_offset);
+			// key is put in order, right_child as its right child
+			void insert_key(index_t key, offset_t record_offset, offset_t right_child, offset_t right_child_parent);
+		};
+
+		// current page is full - key (with its right child) is spread with a sibling which has free space
+		// returns false if neither sibling has free space
+		bool try_compensation(index_t key, offset_t record_offset, offset_t right_child);
+		// keys [first, last) and children [first, last] of entries are put to page - moved children get new parent
+		void fill_page(TreePage& page, PageEntries& entries, std::size_t first, std::size_t last);
+		// current page is full - it is split in two, middle key goes to the parent (or to a new root)
+		// returns false if split created new root, otherwise parent is the current page and key, record_offset and right_child
+		// are set to the middle key and the new page, which are to be inserted to it
+		bool split(index_t& key, offset_t& record_offset, offset_t& right_child);
+
+		/*
+		 * builds the tree from increasing keys - shape of every level follows from number of keys,
+		 * so keys can be routed to their pages in order, one page of each level is kept in memory
+		 * and every page is written once, when it is complete
+		 * index and records are built in new files next to the tree's ones, which they replace when loading finishes -
+		 * if it fails, the tree keeps its content
+		 */
+		class BulkLoader {
+		public:
+			static constexpr std::size_t RECORDS_BUFFER_SIZE = 1 << 20;
+
+			BulkLoader(BTree& tree, unsigned long long keys_count, double fill_factor);
+			BulkLoader(const BulkLoader&) = delete;
+			BulkLoader& operator=(const BulkLoader&) = delete;
+			// removes files of unfinished load
+			~BulkLoader();
+
+			void add(index_t key, const int* data, std::size_t size);
+			// writes pages left in memory and makes the new tree current
+			void finish();
+
+		private:
+			struct Level {
+				unsigned long long keys_count;
+				unsigned long long pages_count;
+				offset_t first_page_offset;
+				// keys are spread evenly - extra_keys first pages have base_keys + 1 keys, the rest base_keys
+				unsigned long long base_keys;
+				unsigned long long extra_keys;
+				// page being filled and number of keys routed to the level (including ones moved up)
+				unsigned long long page_index;
+				unsigned long long keys_routed;
+				TreePage page;
+			};
+
+			BTree* tree;
+			std::string index_path;
+			std::string records_path;
+			std::unique_ptr<RandomAccessFile> index_file;
+			std::unique_ptr<RandomAccessFile> records_file;
+			bool finished = false;
+
+			unsigned long long keys_count;
+			unsigned long long keys_added = 0;
+			index_t last_key = 0;
+			// leaves first, root last
+			std::vector<Level> levels;
+			pooled_vector<char> records_buffer;
+			offset_t records_buffer_offset = 0;
+
+			unsigned long long get_page_keys(const Level& level, unsigned long long page_index) const;
+			// page of the level which has child_index-th page of the level below as a child
+			unsigned long long get_page_of_child(const Level& level, unsigned long long child_index) const;
+			offset_t get_child_offset(std::size_t level, unsigned long long child_index) const;
+			void start_page(std::size_t level, unsigned long long page_index);
+			void flush_records();
+		};
 
 		/* operations on index_file */
+		// pins page and puts it on the path
 		void read_page_from_file(offset_t offset);
+		// marks page as changed - it is written when cache evicts or flushes it
 		void write_page_to_file(TreePage &page);
+		// place for new page at the end of index file
+		offset_t allocate_page();
 		void read_root_offset_from_file();
 		void write_root_offset_to_file();
+		// page size of existing tree, default_page_size for a new one
+		std::size_t read_page_size_from_file(std::size_t default_page_size);
+		// throws if record width of existing tree differs from record_width
+		void check_record_width_in_file();
 		
 
 		/* operations on records_file */
-		ArrayRecord read_record_from_file(offset_t offset);
-		void write_record_to_file(offset_t offset, ArrayRecord& record);
-		offset_t append_record_to_file(ArrayRecord& record);
-
-		std::string metadata_filepath;
-		std::string index_filepath;
-		std::string records_filepath;
-		
-		//std::fstream index_file;
-		//std::fstream records_file;
-		//TreePage root;
+		// record is stored as its size (4 bytes) and record_width ints
+		std::vector<int> read_record_from_file(offset_t offset);
+		void write_record_to_file(offset_t offset, const int* data, std::size_t size);
+		offset_t append_record_to_file(const int* data, std::size_t size);
 	};
 }
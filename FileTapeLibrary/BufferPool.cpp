@@ -0,0 +1,224 @@
+#include "BufferPool.h"
+
+#include <algorithm>
+#include <utility>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+FileTapeLibrary::BufferPool& FileTapeLibrary::BufferPool::instance() {
+	static BufferPool pool;
+	return pool;
+}
+
+FileTapeLibrary::BufferPool::~BufferPool() {
+	release_free_blocks_locked();
+}
+
+void* FileTapeLibrary::BufferPool::allocate(std::size_t size) {
+	auto size_class = get_class(size);
+	auto class_size = get_class_size(size_class);
+	auto lock = std::lock_guard<std::mutex>(mutex);
+
+	// reuse kept block
+	if (!free_blocks[size_class].empty()) {
+		auto block = free_blocks[size_class].back();
+		free_blocks[size_class].pop_back();
+		used_bytes += class_size;
+		return block;
+	}
+
+	if (reserved_bytes + class_size > memory_limit) {
+		// make room with blocks of other sizes
+		release_free_blocks_locked();
+
+		if (reserved_bytes + class_size > memory_limit) {
+			throw std::exception("buffer pool memory limit exceeded");
+		}
+	}
+
+	auto block = allocate_from_system(class_size);
+	used_bytes += class_size;
+	reserved_bytes += class_size;
+	peak_reserved_bytes = std::max(peak_reserved_bytes, reserved_bytes);
+
+	return block;
+}
+
+void FileTapeLibrary::BufferPool::deallocate(void* block, std::size_t size) {
+	if (block == nullptr) {
+		return;
+	}
+
+	auto size_class = get_class(size);
+	auto lock = std::lock_guard<std::mutex>(mutex);
+
+	free_blocks[size_class].push_back(block);
+	used_bytes -= get_class_size(size_class);
+}
+
+void FileTapeLibrary::BufferPool::set_memory_limit(std::size_t bytes) {
+	auto lock = std::lock_guard<std::mutex>(mutex);
+
+	memory_limit = bytes;
+	if (reserved_bytes > memory_limit) {
+		release_free_blocks_locked();
+	}
+}
+
+std::size_t FileTapeLibrary::BufferPool::get_memory_limit() const {
+	auto lock = std::lock_guard<std::mutex>(mutex);
+	return memory_limit;
+}
+
+void FileTapeLibrary::BufferPool::set_huge_pages(bool enabled) {
+	auto lock = std::lock_guard<std::mutex>(mutex);
+	huge_pages = enabled;
+}
+
+bool FileTapeLibrary::BufferPool::get_huge_pages() const {
+	auto lock = std::lock_guard<std::mutex>(mutex);
+	return huge_pages;
+}
+
+void FileTapeLibrary::BufferPool::release_free_blocks() {
+	auto lock = std::lock_guard<std::mutex>(mutex);
+	release_free_blocks_locked();
+}
+
+std::size_t FileTapeLibrary::BufferPool::get_used_bytes() const {
+	auto lock = std::lock_guard<std::mutex>(mutex);
+	return used_bytes;
+}
+
+std::size_t FileTapeLibrary::BufferPool::get_reserved_bytes() const {
+	auto lock = std::lock_guard<std::mutex>(mutex);
+	return reserved_bytes;
+}
+
+std::size_t FileTapeLibrary::BufferPool::get_peak_reserved_bytes() const {
+	auto lock = std::lock_guard<std::mutex>(mutex);
+	return peak_reserved_bytes;
+}
+
+std::size_t FileTapeLibrary::BufferPool::get_class(std::size_t size) {
+	// sizes above the biggest class are rejected before shifting past width of size_t
+	for (auto size_class = std::size_t(0); size_class < CLASSES; ++size_class) {
+		if (get_class_size(size_class) >= size) {
+			return size_class;
+		}
+	}
+
+	throw std::bad_alloc();
+}
+
+std::size_t FileTapeLibrary::BufferPool::get_class_size(std::size_t size_class) {
+	return MIN_BLOCK_SIZE << size_class;
+}
+
+void* FileTapeLibrary::BufferPool::allocate_from_system(std::size_t size) {
+	// small blocks come from heap, big ones are mapped directly (so that they can use huge pages)
+	if (size < HUGE_PAGE_SIZE) {
+		return ::operator new(size, std::align_val_t(MIN_BLOCK_SIZE));
+	}
+
+	void* block = nullptr;
+
+#if defined(_WIN32)
+	if (huge_pages) {
+		// large pages need SeLockMemoryPrivilege - without it normal pages are used
+		auto large_page = GetLargePageMinimum();
+		if (large_page != 0 && size % large_page == 0) {
+			block = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		}
+	}
+	if (block == nullptr) {
+		block = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	}
+	if (block == nullptr) {
+		throw std::bad_alloc();
+	}
+#else
+	block = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (block == MAP_FAILED) {
+		throw std::bad_alloc();
+	}
+#if defined(MADV_HUGEPAGE)
+	if (huge_pages) {
+		// only a hint - kernel may still use normal pages
+		madvise(block, size, MADV_HUGEPAGE);
+	}
+#endif
+#endif
+
+	return block;
+}
+
+void FileTapeLibrary::BufferPool::deallocate_to_system(void* block, std::size_t size) {
+	if (size < HUGE_PAGE_SIZE) {
+		::operator delete(block, std::align_val_t(MIN_BLOCK_SIZE));
+		return;
+	}
+
+#if defined(_WIN32)
+	VirtualFree(block, 0, MEM_RELEASE);
+#else
+	munmap(block, size);
+#endif
+}
+
+void FileTapeLibrary::BufferPool::release_free_blocks_locked() {
+	for (std::size_t size_class = 0; size_class < CLASSES; ++size_class) {
+		for (auto block : free_blocks[size_class]) {
+			deallocate_to_system(block, get_class_size(size_class));
+			reserved_bytes -= get_class_size(size_class);
+		}
+		free_blocks[size_class].clear();
+	}
+}
+
+FileTapeLibrary::PooledBuffer::PooledBuffer(std::size_t size) {
+	block = static_cast<char*>(BufferPool::instance().allocate(size));
+	size_ = size;
+}
+
+FileTapeLibrary::PooledBuffer::PooledBuffer(PooledBuffer&& other) noexcept {
+	std::swap(block, other.block);
+	std::swap(size_, other.size_);
+}
+
+FileTapeLibrary::PooledBuffer& FileTapeLibrary::PooledBuffer::operator=(PooledBuffer&& other) noexcept {
+	if (this != &other) {
+		reset();
+		std::swap(block, other.block);
+		std::swap(size_, other.size_);
+	}
+
+	return *this;
+}
+
+FileTapeLibrary::PooledBuffer::~PooledBuffer() {
+	reset();
+}
+
+char* FileTapeLibrary::PooledBuffer::data() {
+	return block;
+}
+
+const char* FileTapeLibrary::PooledBuffer::data() const {
+	return block;
+}
+
+std::size_t FileTapeLibrary::PooledBuffer::size() const {
+	return size_;
+}
+
+void FileTapeLibrary::PooledBuffer::reset() {
+	BufferPool::instance().deallocate(block, size_);
+	block = nullptr;
+	size_ = 0;
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace FileTapeLibrary {
+	/*
+	 * process-wide pool of memory blocks used by tapes, sort run buffers and B-tree pages
+	 * - blocks are aligned to pages (4 KiB) and have sizes of powers of two - freed blocks are kept and reused
+	 * - large blocks can be backed by huge pages (when system allows it - otherwise normal pages are used)
+	 * - all memory taken from system (blocks in use and kept for reuse) is under one limit;
+	 *   when block doesn't fit, kept blocks are released, and if it still doesn't fit - allocation throws
+	 */
+	class BufferPool {
+	public:
+		static constexpr std::size_t MIN_BLOCK_SIZE = std::size_t(1) << 12;
+		// blocks at least this big are backed by huge pages if they are enabled
+		static constexpr std::size_t HUGE_PAGE_SIZE = std::size_t(1) << 21;
+
+		static BufferPool& instance();
+
+		BufferPool(const BufferPool&) = delete;
+		BufferPool& operator=(const BufferPool&) = delete;
+
+		// block of at least size bytes
+		void* allocate(std::size_t size);
+		// size must be the one block was allocated with
+		void deallocate(void* block, std::size_t size);
+
+		// no limit by default
+		void set_memory_limit(std::size_t bytes);
+		std::size_t get_memory_limit() const;
+		void set_huge_pages(bool enabled);
+		bool get_huge_pages() const;
+		// gives blocks kept for reuse back to system
+		void release_free_blocks();
+
+		// bytes of blocks in use
+		std::size_t get_used_bytes() const;
+		// bytes taken from system (in use and kept for reuse)
+		std::size_t get_reserved_bytes() const;
+		std::size_t get_peak_reserved_bytes() const;
+
+	private:
+		// sizes from MIN_BLOCK_SIZE to 2^(12 + CLASSES - 1)
+		static constexpr std::size_t CLASSES = 40;
+
+		BufferPool() = default;
+		~BufferPool();
+
+		static std::size_t get_class(std::size_t size);
+		static std::size_t get_class_size(std::size_t size_class);
+
+		void* allocate_from_system(std::size_t size);
+		void deallocate_to_system(void* block, std::size_t size);
+		void release_free_blocks_locked();
+
+		mutable std::mutex mutex;
+		std::array<std::vector<void*>, CLASSES> free_blocks;
+		std::size_t memory_limit = static_cast<std::size_t>(-1);
+		bool huge_pages = false;
+		std::size_t used_bytes = 0;
+		std::size_t reserved_bytes = 0;
+		std::size_t peak_reserved_bytes = 0;
+	};
+
+	// block borrowed from BufferPool for the lifetime of the object
+	class PooledBuffer {
+	public:
+		PooledBuffer() = default;
+		explicit PooledBuffer(std::size_t size);
+		PooledBuffer(PooledBuffer&& other) noexcept;
+		PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+		~PooledBuffer();
+
+		char* data();
+		const char* data() const;
+		std::size_t size() const;
+
+	private:
+		void reset();
+
+		char* block = nullptr;
+		std::size_t size_ = 0;
+	};
+
+	// allocator of large buffers (tape and run buffers, block columns, B-tree page images) which takes memory from BufferPool
+	// requests smaller than a block go to std::allocator, so growing containers don't take a whole block and the lock
+	// node based and small containers should use std::allocator directly
+	template <typename T>
+	class PoolAllocator {
+	public:
+		typedef T value_type;
+
+		PoolAllocator() = default;
+		template <typename U>
+		PoolAllocator(const PoolAllocator<U>&) {}
+
+		T* allocate(std::size_t n) {
+			if (n * sizeof(T) < BufferPool::MIN_BLOCK_SIZE) {
+				return std::allocator<T>().allocate(n);
+			}
+			return static_cast<T*>(BufferPool::instance().allocate(n * sizeof(T)));
+		}
+
+		void deallocate(T* p, std::size_t n) {
+			if (n * sizeof(T) < BufferPool::MIN_BLOCK_SIZE) {
+				std::allocator<T>().deallocate(p, n);
+				return;
+			}
+			BufferPool::instance().deallocate(p, n * sizeof(T));
+		}
+
+		template <typename U>
+		bool operator==(const PoolAllocator<U>&) const {
+			return true;
+		}
+
+		template <typename U>
+		bool operator!=(const PoolAllocator<U>&) const {
+			return false;
+		}
+	};
+
+	template <typename T>
+	using pooled_vector = std::vector<T, PoolAllocator<T>>;
+}
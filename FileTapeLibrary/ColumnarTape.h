@@ -0,0 +1,397 @@
+#pragma once
+#include <climits>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ArrayRecord.h"
+#include "BufferPool.h"
+#include "SimdKeys.h"
+#include "Tape.h"
+
+namespace FileTapeLibrary {
+	/*
+	 * tape in columnar (structure of arrays) format - records are stored in blocks of at most BLOCK_LENGTH records
+	 * block:
+	 * - header: number of records, number of values, whether keys column is present (3 x 4 bytes)
+	 * - sizes column: size of every record (4 bytes each)
+	 * - keys column (optional): max() of every record (4 bytes each)
+	 * - values column: elements of all records, one record after another, without padding to record width
+	 *
+	 * readers which need keys only (comparisons, is_sorted, filtering) read sizes and keys and skip values;
+	 * values of a block are read when the first record of the block is reconstructed
+	 */
+	template <typename Record = ArrayRecord>
+	class ColumnarTape {
+	public:
+		typedef BufferedTape::open_mode open_mode;
+
+		static constexpr std::size_t BLOCK_LENGTH = 4096;
+
+		// with_keys tells if keys column is written (write mode only)
+		ColumnarTape(std::string filepath, open_mode mode = BufferedTape::none, bool with_keys = true);
+		~ColumnarTape();
+
+		void open(std::string filepath, open_mode mode);
+		void close();
+
+		/* for write mode only */
+		void write_next_record(const Record& record);
+		// write record which key is already known
+		void write_next_record(const Record& record, int key);
+
+		/* for read mode only - block at a time */
+		// loads next block (without values), returns false if tape has ended
+		bool read_next_block();
+		std::size_t get_block_length() const;
+		// keys of records of current block - computed from values if file has no keys column
+		const int* get_block_keys();
+		// reconstructs record of current block
+		Record get_record(std::size_t position);
+
+		/* for read mode only - record at a time */
+		bool is_empty();
+		Record read_next_record();
+
+		unsigned long long get_page_operations() const;
+		std::string get_filepath() const;
+
+	private:
+		void end_current_mode();
+		void init_mode(open_mode mode);
+		void write_block();
+		void read_block_values();
+
+		open_mode mode = BufferedTape::none;
+		std::string filepath;
+		bool with_keys;
+		std::ifstream in;
+		std::ofstream out;
+
+		// columns of current block - memory is borrowed from BufferPool
+		pooled_vector<std::uint32_t> sizes;
+		pooled_vector<int> keys;
+		pooled_vector<int> values;
+		// in read mode: where each record begins in values column (computed with values)
+		pooled_vector<std::size_t> value_offsets;
+
+		// in read mode: whether file has keys column, whether values of current block are loaded
+		// and where they begin in file
+		bool block_has_keys = false;
+		bool block_keys_ready = false;
+		bool block_values_loaded = false;
+		std::uint32_t block_values_length = 0;
+		std::streamoff block_values_position = 0;
+		// in read mode: next record for record at a time reading
+		std::size_t block_position = 0;
+
+		// counter of block columns read or written
+		unsigned long long page_operations = 0;
+	};
+
+	template <typename Record>
+	ColumnarTape<Record>::ColumnarTape(std::string filepath, open_mode mode, bool with_keys) : filepath(filepath), with_keys(with_keys) {
+		init_mode(mode);
+	}
+
+	template <typename Record>
+	ColumnarTape<Record>::~ColumnarTape() {
+		end_current_mode();
+	}
+
+	template <typename Record>
+	void ColumnarTape<Record>::open(std::string filepath, open_mode mode) {
+		end_current_mode();
+
+		this->filepath = filepath;
+		init_mode(mode);
+	}
+
+	template <typename Record>
+	void ColumnarTape<Record>::close() {
+		end_current_mode();
+	}
+
+	template <typename Record>
+	void ColumnarTape<Record>::write_next_record(const Record& record) {
+		write_next_record(record, record.max());
+	}
+
+	template <typename Record>
+	void ColumnarTape<Record>::write_next_record(const Record& record, int key) {
+		if (mode != BufferedTape::write) {
+			throw std::exception("tape is not in write mode");
+		}
+
+		sizes.push_back(static_cast<std::uint32_t>(record.size()));
+		keys.push_back(key);
+		values.insert(values.end(), record.values(), record.values() + record.size());
+
+		if (sizes.size() == BLOCK_LENGTH) {
+			write_block();
+		}
+	}
+
+	template <typename Record>
+	bool ColumnarTape<Record>::read_next_block() {
+		if (mode != BufferedTape::read) {
+			throw std::exception("tape is not in read mode");
+		}
+
+		// skip values of current block if they haven't been read
+		if (!block_values_loaded && !sizes.empty()) {
+			in.seekg(block_values_position + static_cast<std::streamoff>(block_values_length) * static_cast<std::streamoff>(sizeof(int)));
+		}
+
+		sizes.clear();
+		keys.clear();
+		values.clear();
+		value_offsets.clear();
+		block_position = 0;
+		block_keys_ready = false;
+		block_values_loaded = false;
+
+		std::uint32_t header[3];
+		if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) {
+			return false;
+		}
+
+		auto length = header[0];
+		block_values_length = header[1];
+		block_has_keys = header[2] != 0;
+
+		sizes.resize(length);
+		in.read(reinterpret_cast<char*>(sizes.data()), length * sizeof(std::uint32_t));
+		++page_operations;
+
+		if (block_has_keys) {
+			keys.resize(length);
+			in.read(reinterpret_cast<char*>(keys.data()), length * sizeof(int));
+			++page_operations;
+			block_keys_ready = true;
+		}
+
+		block_values_position = in.tellg();
+		return length > 0;
+	}
+
+	template <typename Record>
+	std::size_t ColumnarTape<Record>::get_block_length() const {
+		return sizes.size();
+	}
+
+	template <typename Record>
+	const int* ColumnarTape<Record>::get_block_keys() {
+		if (!block_keys_ready) {
+			read_block_values();
+
+			keys.resize(sizes.size());
+			for (std::size_t i = 0; i < sizes.size(); ++i) {
+				// record without data has no maximum - it goes first
+				keys[i] = sizes[i] > 0 ? simd::max(values.data() + value_offsets[i], sizes[i], sizes[i]) : INT_MIN;
+			}
+			block_keys_ready = true;
+		}
+
+		return keys.data();
+	}
+
+	template <typename Record>
+	Record ColumnarTape<Record>::get_record(std::size_t position) {
+		read_block_values();
+
+		return Record(values.data() + value_offsets[position], sizes[position]);
+	}
+
+	template <typename Record>
+	bool ColumnarTape<Record>::is_empty() {
+		if (block_position < sizes.size()) {
+			return false;
+		}
+
+		return !read_next_block();
+	}
+
+	template <typename Record>
+	Record ColumnarTape<Record>::read_next_record() {
+		if (is_empty()) {
+			throw std::exception("tape is empty");
+		}
+
+		return get_record(block_position++);
+	}
+
+	template <typename Record>
+	unsigned long long ColumnarTape<Record>::get_page_operations() const {
+		return page_operations;
+	}
+
+	template <typename Record>
+	std::string ColumnarTape<Record>::get_filepath() const {
+		return filepath;
+	}
+
+	template <typename Record>
+	void ColumnarTape<Record>::end_current_mode() {
+		if (mode == BufferedTape::write) {
+			// save records which are left in buffers
+			if (!sizes.empty()) {
+				write_block();
+			}
+			out.close();
+		}
+		else if (mode == BufferedTape::read) {
+			in.close();
+		}
+
+		sizes.clear();
+		keys.clear();
+		values.clear();
+		value_offsets.clear();
+		block_position = 0;
+		mode = BufferedTape::none;
+	}
+
+	template <typename Record>
+	void ColumnarTape<Record>::init_mode(open_mode mode) {
+		this->mode = mode;
+
+		if (mode == BufferedTape::write) {
+			out.open(filepath, std::ios::binary | std::ios::trunc);
+			sizes.reserve(BLOCK_LENGTH);
+			keys.reserve(BLOCK_LENGTH);
+		}
+		else if (mode == BufferedTape::read) {
+			in.open(filepath, std::ios::binary);
+		}
+	}
+
+	template <typename Record>
+	void ColumnarTape<Record>::write_block() {
+		std::uint32_t header[] = {
+			static_cast<std::uint32_t>(sizes.size()),
+			static_cast<std::uint32_t>(values.size()),
+			with_keys ? 1u : 0u
+		};
+
+		out.write(reinterpret_cast<const char*>(header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(sizes.data()), sizes.size() * sizeof(std::uint32_t));
+		++page_operations;
+		if (with_keys) {
+			out.write(reinterpret_cast<const char*>(keys.data()), keys.size() * sizeof(int));
+			++page_operations;
+		}
+		out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(int));
+		++page_operations;
+
+		sizes.clear();
+		keys.clear();
+		values.clear();
+	}
+
+	template <typename Record>
+	void ColumnarTape<Record>::read_block_values() {
+		if (block_values_loaded) {
+			return;
+		}
+
+		in.seekg(block_values_position);
+		values.resize(block_values_length);
+		in.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(int));
+		++page_operations;
+
+		value_offsets.resize(sizes.size());
+		auto offset = std::size_t(0);
+		for (std::size_t i = 0; i < sizes.size(); ++i) {
+			value_offsets[i] = offset;
+			offset += sizes[i];
+		}
+
+		block_values_loaded = true;
+	}
+
+	// rewrites tape of records in columnar format
+	// returns number of disc operations
+	template <typename Record = ArrayRecord>
+	unsigned long long convert_to_columnar(std::string tape_path, std::string columnar_path, bool with_keys = true) {
+		auto input = BasicTape<Record>(tape_path, BufferedTape::read);
+		auto output = ColumnarTape<Record>(columnar_path, BufferedTape::write, with_keys);
+
+		while (!input.is_empty()) {
+			output.write_next_record(input.read_next_record());
+		}
+
+		input.close();
+		output.close();
+		return input.get_page_operations() + output.get_page_operations();
+	}
+
+	// rewrites columnar tape as tape of records
+	// returns number of disc operations
+	template <typename Record = ArrayRecord>
+	unsigned long long convert_from_columnar(std::string columnar_path, std::string tape_path) {
+		auto input = ColumnarTape<Record>(columnar_path, BufferedTape::read);
+		auto output = BasicTape<Record>(tape_path, BufferedTape::write);
+
+		while (!input.is_empty()) {
+			output.write_next_record(input.read_next_record());
+		}
+
+		input.close();
+		output.close();
+		return input.get_page_operations() + output.get_page_operations();
+	}
+
+	// tells if records of columnar tape are ordered ascending by max() - only keys are read
+	template <typename Record = ArrayRecord>
+	bool is_columnar_sorted(std::string columnar_path) {
+		auto input = ColumnarTape<Record>(columnar_path, BufferedTape::read);
+		auto has_last_key = false;
+		auto last_key = 0;
+
+		while (input.read_next_block()) {
+			auto keys = input.get_block_keys();
+			auto length = input.get_block_length();
+
+			// order between blocks
+			if (has_last_key && last_key > keys[0]) {
+				return false;
+			}
+
+			if (simd::find_descent(keys, length) != length) {
+				return false;
+			}
+
+			has_last_key = true;
+			last_key = keys[length - 1];
+		}
+
+		return true;
+	}
+
+	// copies records which max() is in [low, high] to output columnar tape
+	// keys are scanned first - values are read only for blocks which have selected records
+	// returns number of disc operations
+	template <typename Record = ArrayRecord>
+	unsigned long long filter_columnar(std::string columnar_path, std::string output_path, int low, int high) {
+		auto input = ColumnarTape<Record>(columnar_path, BufferedTape::read);
+		auto output = ColumnarTape<Record>(output_path, BufferedTape::write);
+		auto selection = std::vector<std::uint32_t>();
+
+		while (input.read_next_block()) {
+			auto keys = input.get_block_keys();
+			selection.resize(input.get_block_length());
+
+			auto selected = simd::select_in_range(keys, input.get_block_length(), low, high, selection.data());
+
+			for (std::size_t i = 0; i < selected; ++i) {
+				output.write_next_record(input.get_record(selection[i]), keys[selection[i]]);
+			}
+		}
+
+		input.close();
+		output.close();
+		return input.get_page_operations() + output.get_page_operations();
+	}
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <exception>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "ArrayRecord.h"
+#include "SortingPolicy.h"
+
+namespace FileTapeLibrary {
+	/*
+	 * combiner is a type which collapses records of equal keys into one record while they are sorted
+	 * (like combiners of MapReduce - the less records are left, the less data is moved by next phases):
+	 * - combine(accumulated, record) adds record to accumulated - both have equal keys
+	 * - prepare(record) (optional) turns input record into the form which is combined - it is applied once,
+	 *   when record is read by run formation, and key is computed from the prepared record
+	 * combined record must have the same key as records it was combined from
+	 * - required_key_extractor (optional) is the only key extractor prepared records may be sorted with -
+	 *   sorting with another one doesn't compile
+	 */
+
+	namespace detail {
+		// accumulated += value - throws instead of overflowing
+		inline void add_checked(int& accumulated, int value) {
+			auto overflows = value > 0
+				? accumulated > std::numeric_limits<int>::max() - value
+				: accumulated < std::numeric_limits<int>::min() - value;
+			if (overflows) {
+				throw std::exception("Combined value is out of range of int");
+			}
+
+			accumulated += value;
+		}
+	}
+
+	// sort without combining - every record is kept
+	struct NoCombiner {};
+
+	// keeps first record of every key
+	struct DistinctCombiner {
+		template <typename Record>
+		void combine(Record&, const Record&) const {}
+	};
+
+	// counts records of every key - prepared record is { key, count }, so it has to be sorted with FirstKey
+	// count is an int - sort throws if some key has more records
+	template <typename KeyExtractor = MaxKey>
+	class CountCombiner {
+	public:
+		typedef FirstKey required_key_extractor;
+
+		CountCombiner(KeyExtractor key_extractor = KeyExtractor()) : key_extractor(std::move(key_extractor)) {}
+
+		template <typename Record>
+		Record prepare(const Record& record) const {
+			return Record{ key_extractor(record), 1 };
+		}
+
+		template <typename Record>
+		void combine(Record& accumulated, const Record& record) const {
+			detail::add_checked(accumulated[1], record[1]);
+		}
+
+	private:
+		KeyExtractor key_extractor;
+	};
+
+	// sums element at position (0 if record is shorter) over records of every key
+	// prepared record is { key, sum }, so it has to be sorted with FirstKey
+	// sum is an int - sort throws if it goes out of its range
+	template <typename KeyExtractor = MaxKey>
+	class SumCombiner {
+	public:
+		typedef FirstKey required_key_extractor;
+
+		SumCombiner(std::size_t position, KeyExtractor key_extractor = KeyExtractor())
+			: position(position), key_extractor(std::move(key_extractor)) {}
+
+		template <typename Record>
+		Record prepare(const Record& record) const {
+			return Record{ key_extractor(record), position < record.size() ? record[position] : 0 };
+		}
+
+		template <typename Record>
+		void combine(Record& accumulated, const Record& record) const {
+			detail::add_checked(accumulated[1], record[1]);
+		}
+
+	private:
+		std::size_t position;
+		KeyExtractor key_extractor;
+	};
+
+	// custom combiner - accumulated = reduce(accumulated, record)
+	template <typename Reduce>
+	class ReduceCombiner {
+	public:
+		ReduceCombiner(Reduce reduce) : reduce(std::move(reduce)) {}
+
+		template <typename Record>
+		void combine(Record& accumulated, const Record& record) const {
+			accumulated = reduce(accumulated, record);
+		}
+
+	private:
+		Reduce reduce;
+	};
+
+	template <typename Combiner>
+	struct is_combining : std::negation<std::is_same<Combiner, NoCombiner>> {};
+
+	template <typename Combiner, typename = void>
+	struct has_required_key_extractor : std::false_type {};
+
+	template <typename Combiner>
+	struct has_required_key_extractor<Combiner, std::void_t<typename Combiner::required_key_extractor>> : std::true_type {};
+
+	// records prepared by combiner can be sorted with KeyExtractor
+	template <typename Combiner, typename KeyExtractor>
+	constexpr bool is_key_extractor_allowed() {
+		if constexpr (has_required_key_extractor<Combiner>::value) {
+			return std::is_same<typename Combiner::required_key_extractor, KeyExtractor>::value;
+		}
+		else {
+			return true;
+		}
+	}
+
+	template <typename Combiner, typename Record, typename = void>
+	struct has_prepare : std::false_type {};
+
+	template <typename Combiner, typename Record>
+	struct has_prepare<Combiner, Record, std::void_t<decltype(std::declval<const Combiner&>().prepare(std::declval<const Record&>()))>> : std::true_type {};
+
+	// record in the form which is combined
+	template <typename Combiner, typename Record>
+	Record prepare_record(const Combiner& combiner, const Record& record) {
+		if constexpr (has_prepare<Combiner, Record>::value) {
+			return combiner.prepare(record);
+		}
+		else {
+			return record;
+		}
+	}
+}
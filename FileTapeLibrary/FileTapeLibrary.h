@@ -1,32 +1,237 @@
 #pragma once
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <limits>
 #include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 #include "typedefs.h"
 #include "ArrayRecord.h"
 #include "Tape.h"
 #include "BTree.h"
+#include "ColumnarTape.h"
+#include "Generator.h"
+#include "ShardedSort.h"
+#include "TextFormat.h"
 #include "TreePage.h"
 
 namespace FileTapeLibrary {
+	// functions on tapes are templates over record type - ArrayRecord unless stated otherwise
+	template <typename Record = ArrayRecord>
 	void print_file(std::string filepath);
+	template <typename Record = ArrayRecord>
 	void print_file(std::string filepath, std::ostream &logger);
-	void initialize_random_tape(std::string filepath, int random_records_number, int seed = std::mt19937::default_seed);
-	void convert_to_coded_format(std::string user_format_filepath, std::string coded_format_filepath);
-	ArrayRecord read_user_format_record_from_stream(std::istream &in);
-	void copy_file(std::string filepath, std::string output_path);
-	bool is_sorted(std::string filepath, bool sorting_policy(ArrayRecord ar1, ArrayRecord ar2));
-	// returns number of phases and number of disc operations
-	std::tuple<unsigned int, unsigned long long> polyphase_merge_sort(
-		std::string input_path,
-		std::string output_path,
-		bool sorting_policy(ArrayRecord ar1, ArrayRecord ar2)
-	);
-	
-	// returns number of phases and number of disc operations
-	std::tuple<unsigned int, unsigned long long> polyphase_merge_sort(
-		std::string input_path,
-		std::string output_path,
-		bool sorting_policy(ArrayRecord ar1, ArrayRecord ar2),
-		std::ostream& log
-	);
+	// records are formatted in blocks split between threads_count threads (0 - one per hardware thread)
+	// and written in order, one write per block
+	template <typename Record = ArrayRecord>
+	void export_file(std::string filepath, std::ostream& output, text::format text_format = text::format::braces, std::size_t threads_count = 0);
+	template <typename Record = ArrayRecord>
+	void export_file(std::string filepath, std::string output_path, text::format text_format = text::format::braces, std::size_t threads_count = 0);
+	template <typename Record = ArrayRecord>
+	void initialize_random_tape(std::string filepath, unsigned long long random_records_number, int seed = std::mt19937::default_seed);
+	// user format text is parsed in blocks split between threads_count threads (0 - one per hardware thread)
+	template <typename Record = ArrayRecord>
+	void convert_to_coded_format(std::string user_format_filepath, std::string coded_format_filepath, std::size_t threads_count = 0);
+	template <typename Record = ArrayRecord>
+	Record read_user_format_record_from_stream(std::istream &in);
+	template <typename Record = ArrayRecord>
+	void copy_file(std::string filepath, std::string output_path) {
+		auto input = BasicTape<Record>(filepath, BufferedTape::read);
+		auto output = BasicTape<Record>(output_path, BufferedTape::write);
+
+		while (!input.is_empty()) {
+			output.write_next_record(input.read_next_record());
+		}
+	}
+
+	template <typename Record>
+	void print_file(std::string filepath) {
+		print_file<Record>(filepath, std::cout);
+	}
+
+	template <typename Record>
+	void print_file(std::string filepath, std::ostream& logger) {
+		export_file<Record>(filepath, logger, text::format::braces, 1);
+	}
+
+	template <typename Record>
+	void export_file(std::string filepath, std::ostream& output, text::format text_format, std::size_t threads_count) {
+		if (threads_count == 0) {
+			threads_count = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		auto tape = BasicTape<Record>(filepath, BufferedTape::read);
+		auto records = pooled_vector<Record>();
+		// text of every part of block - written in order of parts
+		auto parts = std::vector<pooled_vector<char>>(threads_count);
+		records.reserve(text::EXPORT_BLOCK_LENGTH);
+
+		auto format_part = [&](std::size_t part, std::size_t begin, std::size_t end) {
+			auto& text = parts[part];
+			text.resize((end - begin) * text::get_max_record_length(Record::MAX_SIZE));
+
+			auto out = text.data();
+			for (auto i = begin; i < end; ++i) {
+				out = text::format_values(records[i].values(), records[i].size(), text_format, out);
+			}
+			text.resize(static_cast<std::size_t>(out - text.data()));
+		};
+
+		while (!tape.is_empty()) {
+			records.clear();
+			while (records.size() < text::EXPORT_BLOCK_LENGTH && !tape.is_empty()) {
+				records.push_back(tape.read_next_record());
+			}
+
+			// every part has at least one record
+			auto parts_count = std::min(threads_count, records.size());
+			auto part_length = (records.size() + parts_count - 1) / parts_count;
+			parts_count = (records.size() + part_length - 1) / part_length;
+
+			if (parts_count == 1) {
+				format_part(0, 0, records.size());
+			}
+			else {
+				auto workers = std::vector<std::thread>();
+				for (std::size_t part = 0; part < parts_count; ++part) {
+					workers.emplace_back(format_part, part, part * part_length, std::min(records.size(), (part + 1) * part_length));
+				}
+				for (auto& worker : workers) {
+					worker.join();
+				}
+			}
+
+			for (std::size_t part = 0; part < parts_count; ++part) {
+				output.write(parts[part].data(), static_cast<std::streamsize>(parts[part].size()));
+			}
+		}
+
+		output.flush();
+	}
+
+	template <typename Record>
+	void export_file(std::string filepath, std::string output_path, text::format text_format, std::size_t threads_count) {
+		auto output = std::ofstream(output_path, std::fstream::binary);
+		export_file<Record>(filepath, output, text_format, threads_count);
+	}
+
+	template <typename Record>
+	void initialize_random_tape(std::string filepath, unsigned long long random_records_number, int seed) {
+		auto tape = BasicTape<Record>(filepath, BufferedTape::write);
+		auto engine = std::mt19937(seed);
+		auto size_distribution = std::uniform_int_distribution<std::size_t>(1, Record::MAX_SIZE);
+		auto data_distribution = std::uniform_int_distribution<int>(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+
+		auto size_generator = [&]() { return size_distribution(engine); };
+		auto data_generator = [&]() { return data_distribution(engine); };
+
+		for (auto i = 0ull; i < random_records_number; ++i) {
+			// values are generated directly into the record
+			auto random_record = Record(size_generator());
+			for (std::size_t j = 0; j < random_record.size(); ++j) {
+				random_record[j] = data_generator();
+			}
+
+			tape.write_next_record(random_record);
+		}
+	}
+
+	template <typename Record>
+	void convert_to_coded_format(std::string user_format_filepath, std::string coded_format_filepath, std::size_t threads_count) {
+		if (threads_count == 0) {
+			threads_count = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		auto in = std::ifstream(user_format_filepath, std::fstream::binary);
+		auto tape = BasicTape<Record>(coded_format_filepath, BufferedTape::write);
+
+		// text read from file - unfinished record at the end of block is moved to the beginning of next one
+		auto block = PooledBuffer(text::IMPORT_BLOCK_SIZE);
+		auto block_length = std::size_t(0);
+		// records parsed by every thread - written to tape in order of parts
+		auto parts = std::vector<pooled_vector<Record>>(threads_count);
+		auto errors = std::vector<std::exception_ptr>(threads_count);
+
+		auto parse_part = [&](std::size_t part, const char* begin, const char* end) {
+			try {
+				int values[Record::MAX_SIZE];
+				auto size = std::size_t(0);
+
+				parts[part].clear();
+				while ((begin = text::parse_user_format_values(begin, end, values, Record::MAX_SIZE, size)) != nullptr) {
+					parts[part].emplace_back(values, size);
+				}
+			}
+			catch (...) {
+				errors[part] = std::current_exception();
+			}
+		};
+
+		while (in) {
+			in.read(block.data() + block_length, block.size() - block_length);
+			block_length += static_cast<std::size_t>(in.gcount());
+
+			auto records_length = text::find_records_end(block.data(), block_length);
+			if (records_length == 0 && block_length == block.size()) {
+				throw std::exception("record is too long");
+			}
+
+			auto bounds = text::split_records(block.data(), records_length, threads_count);
+			auto parts_count = bounds.size() - 1;
+
+			if (parts_count == 1) {
+				parse_part(0, block.data(), block.data() + records_length);
+			}
+			else {
+				auto workers = std::vector<std::thread>();
+				for (std::size_t part = 0; part < parts_count; ++part) {
+					workers.emplace_back(parse_part, part, block.data() + bounds[part], block.data() + bounds[part + 1]);
+				}
+				for (auto& worker : workers) {
+					worker.join();
+				}
+			}
+
+			for (std::size_t part = 0; part < parts_count; ++part) {
+				if (errors[part]) {
+					std::rethrow_exception(errors[part]);
+				}
+				tape.write_records(parts[part].data(), parts[part].size());
+			}
+
+			std::memmove(block.data(), block.data() + records_length, block_length - records_length);
+			block_length -= records_length;
+		}
+
+		tape.close();
+	}
+
+	template <typename Record>
+	Record read_user_format_record_from_stream(std::istream& in) {
+		// memory of the line is reused by next calls
+		thread_local auto record_line = std::string();
+
+		if (std::getline(in, record_line, '}') && !in.eof()) {
+			record_line.push_back('}');
+
+			int values[Record::MAX_SIZE];
+			auto size = std::size_t(0);
+
+			// record which doesn't fit in Record::MAX_SIZE throws
+			if (text::parse_user_format_values(record_line.data(), record_line.data() + record_line.size(), values, Record::MAX_SIZE, size) != nullptr) {
+				return Record(values, size);
+			}
+		}
+
+		throw std::exception("Wrong input");
+	}
 }
+
+// sorting algorithms are templates over sorting policy
+#include "Sorting.h"
+#include "Join.h"
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "Generator.h"
+
+FileTapeLibrary::KeyGenerator::KeyGenerator(const GeneratorOptions& options, unsigned long long records_count)
+	: options(options), records_count(records_count) {
+	if ((options.distribution == key_distribution::few_unique || options.distribution == key_distribution::zipf) && options.unique_keys == 0) {
+		throw std::exception("Number of unique keys must be positive");
+	}
+	if (options.distribution == key_distribution::sawtooth && options.period == 0) {
+		throw std::exception("Period must be positive");
+	}
+	if (options.distribution == key_distribution::nearly_sorted && (options.swap_percent < 0 || options.swap_percent > 100)) {
+		throw std::exception("Swap percent must be in [0, 100]");
+	}
+
+	if (options.distribution == key_distribution::zipf) {
+		// probability of key of rank r is proportional to 1 / r^exponent
+		zipf_distribution.resize(options.unique_keys);
+
+		auto sum = 0.0;
+		for (std::size_t rank = 0; rank < options.unique_keys; ++rank) {
+			sum += 1.0 / std::pow(static_cast<double>(rank + 1), options.zipf_exponent);
+			zipf_distribution[rank] = sum;
+		}
+		for (auto& probability : zipf_distribution) {
+			probability /= sum;
+		}
+	}
+}
+
+std::mt19937_64 FileTapeLibrary::KeyGenerator::get_engine(unsigned long long first) const {
+	auto block = first / BLOCK_LENGTH;
+	auto seed = std::seed_seq{
+		static_cast<std::uint32_t>(options.seed), static_cast<std::uint32_t>(options.seed >> 32),
+		static_cast<std::uint32_t>(block), static_cast<std::uint32_t>(block >> 32)
+	};
+
+	return std::mt19937_64(seed);
+}
+
+void FileTapeLibrary::KeyGenerator::generate(unsigned long long first, std::size_t length, std::mt19937_64& engine, int* keys) const {
+	auto any_key = std::uniform_int_distribution<int>(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+	auto probability = std::uniform_real_distribution<double>(0.0, 1.0);
+
+	switch (options.distribution) {
+	case key_distribution::uniform:
+		for (std::size_t i = 0; i < length; ++i) {
+			keys[i] = any_key(engine);
+		}
+		break;
+
+	case key_distribution::sorted:
+		for (std::size_t i = 0; i < length; ++i) {
+			keys[i] = get_sorted_key(first + i, records_count);
+		}
+		break;
+
+	case key_distribution::reverse_sorted:
+		for (std::size_t i = 0; i < length; ++i) {
+			keys[i] = get_sorted_key(records_count - 1 - (first + i), records_count);
+		}
+		break;
+
+	case key_distribution::nearly_sorted: {
+		for (std::size_t i = 0; i < length; ++i) {
+			keys[i] = get_sorted_key(first + i, records_count);
+		}
+
+		// swaps stay in the block - blocks are independent
+		auto swaps = static_cast<std::size_t>(std::llround(length * options.swap_percent / 100.0 / 2.0));
+		auto position = std::uniform_int_distribution<std::size_t>(0, length - 1);
+		for (std::size_t swap = 0; swap < swaps; ++swap) {
+			std::swap(keys[position(engine)], keys[position(engine)]);
+		}
+		break;
+	}
+
+	case key_distribution::few_unique: {
+		auto rank = std::uniform_int_distribution<std::size_t>(0, options.unique_keys - 1);
+		for (std::size_t i = 0; i < length; ++i) {
+			keys[i] = get_sorted_key(rank(engine), options.unique_keys);
+		}
+		break;
+	}
+
+	case key_distribution::zipf:
+		for (std::size_t i = 0; i < length; ++i) {
+			auto rank = std::lower_bound(zipf_distribution.begin(), zipf_distribution.end(), probability(engine)) - zipf_distribution.begin();
+			rank = std::min<std::ptrdiff_t>(rank, static_cast<std::ptrdiff_t>(options.unique_keys) - 1);
+			keys[i] = get_sorted_key(static_cast<unsigned long long>(rank), options.unique_keys);
+		}
+		break;
+
+	case key_distribution::sawtooth:
+		for (std::size_t i = 0; i < length; ++i) {
+			keys[i] = get_sorted_key((first + i) % options.period, options.period);
+		}
+		break;
+	}
+}
+
+int FileTapeLibrary::KeyGenerator::get_sorted_key(unsigned long long i, unsigned long long count) {
+	// keys are spread over whole int range - count can be above 2^32, so position is computed in floating point
+	auto span = static_cast<double>(std::numeric_limits<std::uint32_t>::max());
+	auto offset = static_cast<long long>(static_cast<double>(i) / static_cast<double>(count) * span);
+
+	return static_cast<int>(std::numeric_limits<int>::min() + offset);
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ArrayRecord.h"
+#include "BufferPool.h"
+
+namespace FileTapeLibrary {
+	// how keys (max of records) follow one another on generated tape
+	enum class key_distribution {
+		// independent keys from the whole int range
+		uniform,
+		// non-decreasing keys
+		sorted,
+		// non-increasing keys
+		reverse_sorted,
+		// sorted keys with swap_percent % of records swapped with other records of their block
+		nearly_sorted,
+		// keys drawn from unique_keys values
+		few_unique,
+		// unique_keys values with Zipf distribution (exponent zipf_exponent) - few keys make most of the tape
+		zipf,
+		// sorted series of period records, one after another
+		sawtooth
+	};
+
+	struct GeneratorOptions {
+		key_distribution distribution = key_distribution::uniform;
+		// 0 - one thread per hardware thread
+		std::size_t threads_count = 0;
+		unsigned long long seed = std::mt19937_64::default_seed;
+		double swap_percent = 1.0;
+		std::size_t unique_keys = 16;
+		double zipf_exponent = 1.0;
+		unsigned long long period = 1ull << 16;
+	};
+
+	/*
+	 * keys of generated tape - tape is generated in blocks of BLOCK_LENGTH records
+	 * every block has its own random engine, seeded with (seed, block number), so content of the tape
+	 * doesn't depend on number of threads or on order in which blocks are generated
+	 */
+	class KeyGenerator {
+	public:
+		static constexpr std::size_t BLOCK_LENGTH = std::size_t(1) << 20;
+
+		KeyGenerator(const GeneratorOptions& options, unsigned long long records_count);
+
+		// engine of block which begins with record first
+		std::mt19937_64 get_engine(unsigned long long first) const;
+		// writes keys of records [first, first + length) to keys
+		void generate(unsigned long long first, std::size_t length, std::mt19937_64& engine, int* keys) const;
+
+	private:
+		// i-th of count non-decreasing keys spread over the int range
+		static int get_sorted_key(unsigned long long i, unsigned long long count);
+
+		GeneratorOptions options;
+		unsigned long long records_count;
+		// cumulative probabilities of Zipf distribution
+		std::vector<double> zipf_distribution;
+	};
+
+	// random record which max() is key - key is put on random position, other values aren't bigger than key
+	template <typename Record>
+	Record make_record_with_key(int key, std::mt19937_64& engine) {
+		auto size_distribution = std::uniform_int_distribution<std::size_t>(1, Record::MAX_SIZE);
+		auto data_distribution = std::uniform_int_distribution<int>(std::numeric_limits<int>::min(), key);
+
+		auto record = Record(size_distribution(engine));
+		auto key_position = std::uniform_int_distribution<std::size_t>(0, record.size() - 1)(engine);
+
+		for (std::size_t i = 0; i < record.size(); ++i) {
+			record[i] = i == key_position ? key : data_distribution(engine);
+		}
+
+		return record;
+	}
+
+	// writes records_count records with keys of chosen distribution - blocks of records are generated by threads
+	// and written directly to their places in the file
+	template <typename Record = ArrayRecord>
+	void generate_tape(std::string filepath, unsigned long long records_count, const GeneratorOptions& options = GeneratorOptions()) {
+		auto generator = KeyGenerator(options, records_count);
+		auto blocks_count = (records_count + KeyGenerator::BLOCK_LENGTH - 1) / KeyGenerator::BLOCK_LENGTH;
+
+		auto threads_count = options.threads_count;
+		if (threads_count == 0) {
+			threads_count = std::max(1u, std::thread::hardware_concurrency());
+		}
+		threads_count = static_cast<std::size_t>(std::min<unsigned long long>(threads_count, std::max(1ull, blocks_count)));
+
+		// file has its final size before blocks are written
+		std::ofstream(filepath, std::ios::binary | std::ios::trunc).close();
+		std::filesystem::resize_file(filepath, records_count * sizeof(Record));
+
+		auto errors = std::vector<std::exception_ptr>(threads_count);
+
+		// thread t generates blocks t, t + threads_count, ...
+		auto generate_blocks = [&](std::size_t thread) {
+			try {
+				auto file = std::ofstream(filepath, std::ios::binary | std::ios::in | std::ios::out);
+				auto keys = pooled_vector<int>(KeyGenerator::BLOCK_LENGTH);
+				auto records = pooled_vector<Record>();
+				records.reserve(KeyGenerator::BLOCK_LENGTH);
+
+				for (auto block = static_cast<unsigned long long>(thread); block < blocks_count; block += threads_count) {
+					auto first = block * KeyGenerator::BLOCK_LENGTH;
+					auto length = static_cast<std::size_t>(std::min<unsigned long long>(KeyGenerator::BLOCK_LENGTH, records_count - first));
+					auto engine = generator.get_engine(first);
+
+					generator.generate(first, length, engine, keys.data());
+
+					records.clear();
+					for (std::size_t i = 0; i < length; ++i) {
+						records.push_back(make_record_with_key<Record>(keys[i], engine));
+					}
+
+					file.seekp(static_cast<std::streamoff>(first * sizeof(Record)));
+					file.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(length * sizeof(Record)));
+				}
+
+				if (!file) {
+					throw std::exception("Could not write generated tape");
+				}
+			}
+			catch (...) {
+				errors[thread] = std::current_exception();
+			}
+		};
+
+		if (threads_count == 1) {
+			generate_blocks(0);
+		}
+		else {
+			auto workers = std::vector<std::thread>();
+			for (std::size_t thread = 0; thread < threads_count; ++thread) {
+				workers.emplace_back(generate_blocks, thread);
+			}
+			for (auto& worker : workers) {
+				worker.join();
+			}
+		}
+
+		for (const auto& error : errors) {
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+	}
+}
@@ -0,0 +1,202 @@
+#pragma once
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "ArrayRecord.h"
+#include "KeyedTape.h"
+#include "RunIndex.h"
+#include "Sorting.h"
+#include "SortingPolicy.h"
+
+namespace FileTapeLibrary {
+	// joined record of default join - values of left record followed by values of right record
+	struct ConcatenateRecords {
+		template <std::size_t N>
+		BasicArrayRecord<2 * N> operator()(const BasicArrayRecord<N>& left, const BasicArrayRecord<N>& right) const {
+			auto joined = BasicArrayRecord<2 * N>(left.size() + right.size());
+
+			std::copy(left.values(), left.values() + left.size(), &joined[0]);
+			std::copy(right.values(), right.values() + right.size(), &joined[left.size()]);
+
+			return joined;
+		}
+	};
+
+	// how many records of one key of right tape are kept in memory by merge join
+	constexpr std::size_t JOIN_GROUP_LENGTH = std::size_t(1) << 16;
+
+	struct MergeJoinOptions {
+		// directory of sorted copies of inputs and of spilled groups
+		std::string scratch_directory = DEFAULT_SCRATCH_DIRECTORY;
+		// records of one key of right tape above this number are spilled to a tape in scratch directory
+		std::size_t group_length = JOIN_GROUP_LENGTH;
+		// input with run index of one series (written by sorts of this library) is taken as sorted without reading it
+		// - set only if inputs were sorted by the join key
+		bool trust_run_indexes = false;
+	};
+
+	namespace detail {
+		// tapes have no header - number of records is given by size of the file
+		template <typename Record>
+		unsigned long long get_records_count(const std::string& filepath) {
+			auto file = std::ifstream(filepath, std::ios::binary | std::ios::ate);
+			if (!file) {
+				return 0;
+			}
+
+			return static_cast<unsigned long long>(file.tellg()) / sizeof(Record);
+		}
+
+		// tape sorted by policy - input tape itself if it is sorted, otherwise its copy sorted to sorted_path
+		template <typename Policy>
+		std::string get_sorted_tape(
+			const std::string& input_path,
+			const std::string& sorted_path,
+			const Policy& policy,
+			const MergeJoinOptions& options,
+			unsigned long long& page_operations
+		) {
+			typedef typename Policy::record_type record_type;
+
+			if (options.trust_run_indexes && RunIndex::is_single_run(input_path, get_records_count<record_type>(input_path))) {
+				return input_path;
+			}
+
+			if (is_sorted(input_path, policy)) {
+				return input_path;
+			}
+
+			page_operations += std::get<1>(polyphase_merge_sort(input_path, sorted_path, policy, options.scratch_directory));
+			return sorted_path;
+		}
+	}
+
+	/*
+	 * inner join of two tapes on equal keys - for every pair of left and right records of equal keys
+	 * join(left, right) is written to output tape
+	 *
+	 * inputs which aren't sorted by key are sorted to scratch directory first, then both tapes are read once:
+	 * records of one key of right tape are gathered in memory (the ones above options.group_length on a tape)
+	 * and joined with every left record of that key
+	 *
+	 * output is ordered by keys of the inputs, left records in order of left tape
+	 * returns number of joined records and number of disc operations
+	 */
+	template <typename Record = ArrayRecord, typename KeyExtractor = MaxKey, typename Join = ConcatenateRecords>
+	std::tuple<unsigned long long, unsigned long long> merge_join(
+		std::string left_path,
+		std::string right_path,
+		std::string output_path,
+		const KeyExtractor& key_extractor = KeyExtractor(),
+		const Join& join = Join(),
+		const MergeJoinOptions& options = MergeJoinOptions()
+	) {
+		typedef KeySortingPolicy<KeyExtractor, std::less_equal<>, Record> policy_type;
+		typedef typename policy_type::key_type key_type;
+		typedef std::decay_t<std::invoke_result_t<const Join&, const Record&, const Record&>> output_record_type;
+
+		if (options.group_length == 0) {
+			throw std::exception("Group length must be positive");
+		}
+
+		auto policy = policy_type(key_extractor);
+		auto page_operations = 0ull;
+
+		auto left_sorted_path = detail::get_sorted_tape(left_path, options.scratch_directory + "/join_left.dat", policy, options, page_operations);
+		auto right_sorted_path = detail::get_sorted_tape(right_path, options.scratch_directory + "/join_right.dat", policy, options, page_operations);
+		auto group_path = options.scratch_directory + "/join_group.dat";
+
+		auto left = KeyedTape<policy_type>(left_sorted_path, BufferedTape::read, policy);
+		auto right = KeyedTape<policy_type>(right_sorted_path, BufferedTape::read, policy);
+		auto output = BasicTape<output_record_type>(output_path, BufferedTape::write);
+		auto spilled_group = BasicTape<Record>(group_path);
+
+		// records of right tape with current key
+		auto group = std::vector<Record>();
+		auto spilled_length = 0ull;
+		auto joined_count = 0ull;
+
+		left.read_next_record();
+		right.read_next_record();
+
+		while (left.get_current_record().is_valid() && right.get_current_record().is_valid()) {
+			// key of left record is smaller - it has no pair
+			if (!policy(right.get_current_key(), left.get_current_key())) {
+				left.read_next_record();
+				continue;
+			}
+			// key of right record is smaller
+			if (!policy(left.get_current_key(), right.get_current_key())) {
+				right.read_next_record();
+				continue;
+			}
+
+			auto key = key_type(right.get_current_key());
+
+			// gather right records of the key - tape is sorted, so they are the ones which aren't bigger than the key
+			group.clear();
+			spilled_length = 0;
+
+			do {
+				if (group.size() < options.group_length) {
+					group.push_back(right.get_current_record());
+				}
+				else {
+					if (spilled_length == 0) {
+						spilled_group.open(group_path, BufferedTape::write);
+					}
+					spilled_group.write_next_record(right.get_current_record());
+					++spilled_length;
+				}
+
+				right.read_next_record();
+			} while (right.get_current_record().is_valid() && policy(right.get_current_key(), key));
+
+			if (spilled_length > 0) {
+				spilled_group.close();
+			}
+
+			// join every left record of the key with the group
+			do {
+				const auto& left_record = left.get_current_record();
+
+				for (const auto& right_record : group) {
+					output.write_next_record(join(left_record, right_record));
+				}
+
+				if (spilled_length > 0) {
+					spilled_group.open(group_path, BufferedTape::read);
+					while (!spilled_group.is_empty()) {
+						output.write_next_record(join(left_record, spilled_group.read_next_record()));
+					}
+					spilled_group.close();
+				}
+
+				joined_count += group.size() + spilled_length;
+				left.read_next_record();
+			} while (left.get_current_record().is_valid() && policy(left.get_current_key(), key));
+		}
+
+		left.close();
+		right.close();
+		output.close();
+		page_operations += left.get_page_operations() + right.get_page_operations()
+			+ output.get_page_operations() + spilled_group.get_page_operations();
+
+		// remove sorted copies of inputs
+		for (const auto& path : { left_sorted_path, right_sorted_path }) {
+			if (path != left_path && path != right_path) {
+				std::filesystem::remove(path);
+				std::filesystem::remove(RunIndex::get_sidecar_path(path));
+			}
+		}
+		std::filesystem::remove(group_path);
+
+		return std::make_tuple(joined_count, page_operations);
+	}
+}
@@ -0,0 +1,21 @@
+#include "KeyOffsetRecord.h"
+
+FileTapeLibrary::KeyOffsetRecord FileTapeLibrary::KeyOffsetRecord::DNEKeyOffsetRecord() {
+	return KeyOffsetRecord{ 0, NIL_OFFSET };
+}
+
+bool FileTapeLibrary::KeyOffsetRecord::is_valid() const {
+	return offset != NIL_OFFSET;
+}
+
+namespace FileTapeLibrary {
+	std::ostream& operator<<(std::ostream& os, const KeyOffsetRecord& record) {
+		if (!record.is_valid()) {
+			os << "DNE";
+			return os;
+		}
+
+		os << "{ " << record.key << " @ " << record.offset << " }";
+		return os;
+	}
+}
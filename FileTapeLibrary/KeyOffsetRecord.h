@@ -0,0 +1,37 @@
+#pragma once
+#include <ostream>
+
+#include "typedefs.h"
+#include "Tape.h"
+
+namespace FileTapeLibrary {
+	// sort key of a record together with offset of that record in its file
+	// packed, so that tape of keys is as small as possible
+#pragma pack(push, 1)
+	struct KeyOffsetRecord {
+		int key;
+		offset_t offset;
+
+		// special record with NIL_OFFSET - used to indicate that it is empty, not existing record
+		static KeyOffsetRecord DNEKeyOffsetRecord();
+
+		bool is_valid() const;
+	};
+#pragma pack(pop)
+
+	// key extractor of KeyOffsetRecord
+	struct OffsetRecordKey {
+		int operator()(const KeyOffsetRecord& record) const {
+			return record.key;
+		}
+	};
+
+	template <>
+	struct record_traits<KeyOffsetRecord> {
+		static KeyOffsetRecord dne() {
+			return KeyOffsetRecord::DNEKeyOffsetRecord();
+		}
+	};
+
+	std::ostream& operator<<(std::ostream& os, const KeyOffsetRecord& record);
+}
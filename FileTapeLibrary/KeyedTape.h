@@ -0,0 +1,72 @@
+#pragma once
+#include "Tape.h"
+#include "SortingPolicy.h"
+
+namespace FileTapeLibrary {
+	// tape which keeps sort keys of its current and last record
+	// key is computed once - when record is read (or passed along with record when written)
+	template <typename Policy>
+	class KeyedTape : public BasicTape<typename Policy::record_type> {
+	public:
+		typedef typename Policy::record_type record_type;
+		typedef typename Policy::key_type key_type;
+		typedef BufferedTape::open_mode open_mode;
+
+		KeyedTape(std::string filepath, open_mode mode, const Policy& policy)
+			: BasicTape<record_type>(filepath, mode), policy(policy) {}
+
+		const record_type& read_next_record() {
+			auto& record = BasicTape<record_type>::read_next_record();
+
+			std::swap(last_key, current_key);
+			if (record.is_valid()) {
+				current_key = policy.key(record);
+			}
+
+			return record;
+		}
+
+		void write_next_record(const record_type& record) {
+			write_next_record(record, policy.key(record));
+		}
+
+		// write record which key is already known
+		void write_next_record(const record_type& record, const key_type& key) {
+			BasicTape<record_type>::write_next_record(record);
+
+			std::swap(last_key, current_key);
+			current_key = key;
+		}
+
+		// keys are valid only if respective records are valid
+		const key_type& get_current_key() const {
+			return current_key;
+		}
+
+		const key_type& get_last_key() const {
+			return last_key;
+		}
+
+		bool is_progressing() const {
+			// if one or no record has been read - series is progressing
+			if (!this->get_last_record().is_valid()) {
+				return true;
+			}
+
+			if (!this->get_current_record().is_valid()) {
+				return false;
+			}
+
+			return policy(last_key, current_key);
+		}
+
+		const Policy& get_policy() const {
+			return policy;
+		}
+
+	private:
+		Policy policy;
+		key_type current_key = key_type();
+		key_type last_key = key_type();
+	};
+}
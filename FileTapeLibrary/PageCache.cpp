@@ -0,0 +1,136 @@
+#include "PageCache.h"
+
+FileTapeLibrary::PageCache::PageCache(RandomAccessFile& index_file, std::size_t page_size, std::size_t capacity) {
+	if (capacity == 0) {
+		throw std::exception("Capacity of page cache must be positive");
+	}
+
+	this->index_file = &index_file;
+	this->page_size = page_size;
+	this->capacity = capacity;
+}
+
+FileTapeLibrary::TreePage& FileTapeLibrary::PageCache::pin(offset_t offset) {
+	auto frame = frames.find(offset);
+
+	if (frame != frames.end()) {
+		++hits;
+	}
+	else {
+		++misses;
+		make_place();
+
+		auto page = TreePage(offset, page_size);
+		page.read_from_file(*index_file);
+		++page_reads;
+
+		frame = add_frame(page, false);
+	}
+
+	// most recently used page goes to the end
+	lru.splice(lru.end(), lru, frame->second.position);
+	++frame->second.pins;
+
+	return frame->second.page;
+}
+
+FileTapeLibrary::TreePage& FileTapeLibrary::PageCache::pin_new(offset_t offset) {
+	if (frames.count(offset) > 0) {
+		throw std::exception("Page is already in cache");
+	}
+
+	make_place();
+
+	auto frame = add_frame(TreePage(offset, page_size), true);
+	++frame->second.pins;
+
+	return frame->second.page;
+}
+
+void FileTapeLibrary::PageCache::unpin(offset_t offset) {
+	auto frame = frames.find(offset);
+	if (frame == frames.end() || frame->second.pins == 0) {
+		throw std::exception("Page is not pinned");
+	}
+
+	--frame->second.pins;
+}
+
+void FileTapeLibrary::PageCache::mark_dirty(offset_t offset) {
+	auto frame = frames.find(offset);
+	if (frame == frames.end()) {
+		throw std::exception("Page is not in cache");
+	}
+
+	frame->second.dirty = true;
+}
+
+void FileTapeLibrary::PageCache::flush() {
+	for (auto& [offset, frame] : frames) {
+		if (frame.dirty) {
+			write_page(frame.page);
+			frame.dirty = false;
+		}
+	}
+}
+
+void FileTapeLibrary::PageCache::clear() {
+	frames.clear();
+	lru.clear();
+}
+
+std::size_t FileTapeLibrary::PageCache::get_capacity() const {
+	return capacity;
+}
+
+unsigned long long FileTapeLibrary::PageCache::get_hits() const {
+	return hits;
+}
+
+unsigned long long FileTapeLibrary::PageCache::get_misses() const {
+	return misses;
+}
+
+unsigned long long FileTapeLibrary::PageCache::get_page_reads() const {
+	return page_reads;
+}
+
+unsigned long long FileTapeLibrary::PageCache::get_page_writes() const {
+	return page_writes;
+}
+
+void FileTapeLibrary::PageCache::make_place() {
+	if (frames.size() < capacity) {
+		return;
+	}
+
+	// least recently used page which is not pinned
+	for (auto offset = lru.begin(); offset != lru.end(); ++offset) {
+		auto frame = frames.find(*offset);
+		if (frame->second.pins > 0) {
+			continue;
+		}
+
+		if (frame->second.dirty) {
+			write_page(frame->second.page);
+		}
+
+		lru.erase(offset);
+		frames.erase(frame);
+		return;
+	}
+
+	throw std::exception("All pages in cache are pinned");
+}
+
+FileTapeLibrary::PageCache::frame_map::iterator FileTapeLibrary::PageCache::add_frame(TreePage page, bool dirty) {
+	auto offset = page.get_self_offset();
+	auto position = lru.insert(lru.end(), offset);
+
+	return frames.emplace(offset, Frame{ page, 0, dirty, position }).first;
+}
+
+void FileTapeLibrary::PageCache::write_page(TreePage& page) {
+	page.write_to_file(*index_file);
+	++page_writes;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <list>
+#include <unordered_map>
+
+#include "typedefs.h"
+#include "RandomAccessFile.h"
+#include "TreePage.h"
+
+namespace FileTapeLibrary {
+	/*
+	 * fixed-capacity cache of pages of index file with LRU eviction
+	 * pages are pinned while they are used - pinned pages are never evicted, references to them stay valid
+	 * changed pages are marked dirty and written back when they are evicted or flushed
+	 */
+	class PageCache {
+	public:
+		static constexpr std::size_t DEFAULT_CAPACITY = 1024;
+
+		// index_file must outlive the cache
+		PageCache(RandomAccessFile& index_file, std::size_t page_size = TreePage::DEFAULT_SIZE, std::size_t capacity = DEFAULT_CAPACITY);
+		PageCache(const PageCache&) = delete;
+		PageCache& operator=(const PageCache&) = delete;
+
+		// page from cache, read from file on miss
+		TreePage& pin(offset_t offset);
+		// empty page which is not in file yet - it is dirty
+		TreePage& pin_new(offset_t offset);
+		void unpin(offset_t offset);
+		void mark_dirty(offset_t offset);
+
+		// writes dirty pages to file
+		void flush();
+		// forgets all pages without writing them - no page may be pinned
+		void clear();
+
+		std::size_t get_capacity() const;
+		unsigned long long get_hits() const;
+		unsigned long long get_misses() const;
+		// pages read from and written to index file
+		unsigned long long get_page_reads() const;
+		unsigned long long get_page_writes() const;
+
+	private:
+		// nodes of bookkeeping are small - only page images are taken from BufferPool
+		typedef std::list<offset_t> lru_list;
+
+		struct Frame {
+			TreePage page;
+			std::size_t pins;
+			bool dirty;
+			// place in lru list
+			lru_list::iterator position;
+		};
+
+		typedef std::unordered_map<offset_t, Frame> frame_map;
+
+		// makes place for one more page - throws if every page is pinned
+		void make_place();
+		frame_map::iterator add_frame(TreePage page, bool dirty);
+		void write_page(TreePage& page);
+
+		RandomAccessFile* index_file;
+		std::size_t page_size;
+		std::size_t capacity;
+
+		frame_map frames;
+		// offsets from least to most recently used
+		lru_list lru;
+
+		unsigned long long hits = 0;
+		unsigned long long misses = 0;
+		unsigned long long page_reads = 0;
+		unsigned long long page_writes = 0;
+	};
+}
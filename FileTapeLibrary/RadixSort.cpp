@@ -0,0 +1,117 @@
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <array>
+#include <thread>
+
+namespace {
+	constexpr std::size_t RADIX_BITS = 8;
+	constexpr std::size_t BUCKETS = std::size_t(1) << RADIX_BITS;
+	constexpr std::size_t PASSES = sizeof(int) * 8 / RADIX_BITS;
+	// for smaller inputs starting threads costs more than sorting
+	constexpr std::size_t PARALLEL_THRESHOLD = std::size_t(1) << 16;
+
+	typedef std::array<std::size_t, BUCKETS> histogram_t;
+
+	// flipping the sign bit makes unsigned order of keys equal to their signed order
+	inline std::size_t digit(int key, std::size_t pass) {
+		auto bits = static_cast<std::uint32_t>(key) ^ 0x80000000u;
+		return (bits >> (pass * RADIX_BITS)) & (BUCKETS - 1);
+	}
+}
+
+void FileTapeLibrary::radix_sort(std::vector<KeyIndex>& items, bool parallel) {
+	auto n = items.size();
+	if (n < 2) {
+		return;
+	}
+
+	auto threads_count = std::size_t(1);
+	if (parallel && n >= PARALLEL_THRESHOLD) {
+		threads_count = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// every thread works on its own continuous chunk of items
+	auto chunk_size = (n + threads_count - 1) / threads_count;
+	auto chunk_begin = [&](std::size_t t) { return std::min(n, t * chunk_size); };
+
+	// calls job(t) for every chunk
+	auto for_each_chunk = [&](auto job) {
+		if (threads_count == 1) {
+			job(std::size_t(0));
+			return;
+		}
+
+		auto workers = std::vector<std::thread>();
+		for (std::size_t t = 0; t < threads_count; ++t) {
+			workers.emplace_back(job, t);
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	};
+
+	// histograms of all passes in one read of keys - tells which passes can be skipped
+	auto totals = std::array<histogram_t, PASSES>();
+	for (auto& histogram : totals) {
+		histogram.fill(0);
+	}
+	for (const auto& item : items) {
+		for (std::size_t pass = 0; pass < PASSES; ++pass) {
+			++totals[pass][digit(item.key, pass)];
+		}
+	}
+
+	auto buffer = std::vector<KeyIndex>(n);
+	auto* source = &items;
+	auto* destination = &buffer;
+
+	// chunk_offsets[t][b] - where thread t writes its next item with digit b
+	auto chunk_offsets = std::vector<histogram_t>(threads_count);
+
+	for (std::size_t pass = 0; pass < PASSES; ++pass) {
+		// all keys have the same digit - pass would not change the order
+		if (std::find(totals[pass].begin(), totals[pass].end(), n) != totals[pass].end()) {
+			continue;
+		}
+
+		if (threads_count == 1) {
+			chunk_offsets[0] = totals[pass];
+		}
+		else {
+			// order of items changes with every pass, so histograms of chunks must be counted again
+			for_each_chunk([&](std::size_t t) {
+				auto& histogram = chunk_offsets[t];
+				histogram.fill(0);
+				for (auto i = chunk_begin(t); i < chunk_begin(t + 1); ++i) {
+					++histogram[digit((*source)[i].key, pass)];
+				}
+			});
+		}
+
+		// turn counts into offsets - bucket by bucket, chunk by chunk to keep sort stable
+		auto offset = std::size_t(0);
+		for (std::size_t b = 0; b < BUCKETS; ++b) {
+			for (std::size_t t = 0; t < threads_count; ++t) {
+				auto count = chunk_offsets[t][b];
+				chunk_offsets[t][b] = offset;
+				offset += count;
+			}
+		}
+
+		for_each_chunk([&](std::size_t t) {
+			auto& offsets = chunk_offsets[t];
+			for (auto i = chunk_begin(t); i < chunk_begin(t + 1); ++i) {
+				const auto& item = (*source)[i];
+				(*destination)[offsets[digit(item.key, pass)]++] = item;
+			}
+		});
+
+		std::swap(source, destination);
+	}
+
+	// sorted data ended in the buffer
+	if (source != &items) {
+		items.swap(buffer);
+	}
+}
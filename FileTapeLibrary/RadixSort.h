@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace FileTapeLibrary {
+	// sort key extracted from a record together with position of that record in memory
+	struct KeyIndex {
+		int key;
+		std::uint32_t index;
+	};
+
+	// LSD radix sort of keys (8 bits per pass)
+	// - stable - records with equal keys keep their order
+	// - keys are signed, negative keys go first
+	// - passes in which all keys have the same digit are skipped
+	// - if parallel is set, histograms and scatters are split between hardware threads
+	void radix_sort(std::vector<KeyIndex>& items, bool parallel = false);
+}
@@ -0,0 +1,178 @@
+#include "RandomAccessFile.h"
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FileTapeLibrary::RandomAccessFile::RandomAccessFile(std::string filepath) {
+	this->filepath = filepath;
+	open();
+}
+
+FileTapeLibrary::RandomAccessFile::~RandomAccessFile() {
+	close();
+}
+
+void FileTapeLibrary::RandomAccessFile::replace_with(std::string source_path, std::string backup_path) {
+	close();
+
+	// file is reopened whether renames succeed or not
+	auto error = std::error_code();
+	if (!backup_path.empty()) {
+		std::filesystem::rename(filepath, backup_path, error);
+	}
+	if (!error) {
+		std::filesystem::rename(source_path, filepath, error);
+		if (error && !backup_path.empty()) {
+			// old file is moved back - if that fails too, it stays at backup_path
+			auto restore_error = std::error_code();
+			std::filesystem::rename(backup_path, filepath, restore_error);
+		}
+	}
+	open();
+
+	if (error) {
+		throw std::exception("Could not replace file");
+	}
+}
+
+void FileTapeLibrary::RandomAccessFile::open() {
+#if defined(_WIN32)
+	handle = CreateFileA(filepath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		throw std::exception("Could not open file");
+	}
+#else
+	descriptor = ::open(filepath.c_str(), O_RDWR | O_CREAT, 0644);
+	if (descriptor < 0) {
+		throw std::exception("Could not open file");
+	}
+#endif
+}
+
+void FileTapeLibrary::RandomAccessFile::close() {
+	// file which failed to reopen is already closed
+#if defined(_WIN32)
+	if (handle != INVALID_HANDLE_VALUE) {
+		CloseHandle(handle);
+		handle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (descriptor >= 0) {
+		::close(descriptor);
+		descriptor = -1;
+	}
+#endif
+}
+
+std::size_t FileTapeLibrary::RandomAccessFile::read_at(offset_t offset, char* data, std::size_t size) {
+	auto done = std::size_t(0);
+
+	// one call is enough for whole pages and records - loop only covers interrupted and very big reads
+	while (done < size) {
+#if defined(_WIN32)
+		auto overlapped = OVERLAPPED();
+		overlapped.Offset = static_cast<DWORD>(offset + done);
+		overlapped.OffsetHigh = static_cast<DWORD>((offset + done) >> 32);
+
+		auto chunk = static_cast<DWORD>(std::min<std::size_t>(size - done, 1u << 30));
+		auto read = DWORD();
+		if (!ReadFile(handle, data + done, chunk, &read, &overlapped)) {
+			if (GetLastError() == ERROR_HANDLE_EOF) {
+				break;
+			}
+			throw std::exception("Could not read file");
+		}
+#else
+		auto read = pread(descriptor, data + done, size - done, static_cast<off_t>(offset + done));
+		if (read < 0) {
+			throw std::exception("Could not read file");
+		}
+#endif
+		if (read == 0) {
+			break;
+		}
+		done += static_cast<std::size_t>(read);
+	}
+
+	return done;
+}
+
+void FileTapeLibrary::RandomAccessFile::write_at(offset_t offset, const char* data, std::size_t size) {
+	auto done = std::size_t(0);
+
+	while (done < size) {
+#if defined(_WIN32)
+		auto overlapped = OVERLAPPED();
+		overlapped.Offset = static_cast<DWORD>(offset + done);
+		overlapped.OffsetHigh = static_cast<DWORD>((offset + done) >> 32);
+
+		auto chunk = static_cast<DWORD>(std::min<std::size_t>(size - done, 1u << 30));
+		auto written = DWORD();
+		if (!WriteFile(handle, data + done, chunk, &written, &overlapped)) {
+			throw std::exception("Could not write file");
+		}
+#else
+		auto written = pwrite(descriptor, data + done, size - done, static_cast<off_t>(offset + done));
+		if (written < 0) {
+			throw std::exception("Could not write file");
+		}
+#endif
+		done += static_cast<std::size_t>(written);
+	}
+}
+
+FileTapeLibrary::offset_t FileTapeLibrary::RandomAccessFile::get_size() {
+#if defined(_WIN32)
+	auto size = LARGE_INTEGER();
+	if (!GetFileSizeEx(handle, &size)) {
+		throw std::exception("Could not get size of file");
+	}
+	return static_cast<offset_t>(size.QuadPart);
+#else
+	struct stat status;
+	if (fstat(descriptor, &status) != 0) {
+		throw std::exception("Could not get size of file");
+	}
+	return static_cast<offset_t>(status.st_size);
+#endif
+}
+
+void FileTapeLibrary::RandomAccessFile::truncate(offset_t size) {
+#if defined(_WIN32)
+	auto position = LARGE_INTEGER();
+	position.QuadPart = static_cast<LONGLONG>(size);
+	if (!SetFilePointerEx(handle, position, nullptr, FILE_BEGIN) || !SetEndOfFile(handle)) {
+		throw std::exception("Could not truncate file");
+	}
+#else
+	if (ftruncate(descriptor, static_cast<off_t>(size)) != 0) {
+		throw std::exception("Could not truncate file");
+	}
+#endif
+}
+
+void FileTapeLibrary::RandomAccessFile::sync() {
+#if defined(_WIN32)
+	if (!FlushFileBuffers(handle)) {
+		throw std::exception("Could not sync file");
+	}
+#else
+	if (fsync(descriptor) != 0) {
+		throw std::exception("Could not sync file");
+	}
+#endif
+}
+
+std::string FileTapeLibrary::RandomAccessFile::get_filepath() const {
+	return filepath;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+#include "typedefs.h"
+
+namespace FileTapeLibrary {
+	// file held open for the lifetime of the object - every read and write is one positional call
+	// (pread/pwrite, ReadFile/WriteFile with offset on Windows), so there is no shared file position
+	class RandomAccessFile {
+	public:
+		// file is created if it doesn't exist
+		RandomAccessFile(std::string filepath);
+		RandomAccessFile(const RandomAccessFile&) = delete;
+		RandomAccessFile& operator=(const RandomAccessFile&) = delete;
+		~RandomAccessFile();
+
+		// reads up to size bytes from offset - returns number of bytes read (less at end of file)
+		std::size_t read_at(offset_t offset, char* data, std::size_t size);
+		void write_at(offset_t offset, const char* data, std::size_t size);
+
+		offset_t get_size();
+		void truncate(offset_t size = 0);
+		// waits until written data is on the device
+		void sync();
+
+		std::string get_filepath() const;
+
+		// file at source_path takes place of this file (which is closed, replaced and opened again) -
+		// if backup_path is given, old file is moved there first and it is moved back if replacing fails
+		void replace_with(std::string source_path, std::string backup_path = "");
+
+	private:
+		void open();
+		void close();
+
+#if defined(_WIN32)
+		void* handle;
+#else
+		int descriptor;
+#endif
+		std::string filepath;
+	};
+}
@@ -0,0 +1,145 @@
+#include "RunIndex.h"
+
+std::string FileTapeLibrary::RunIndex::get_sidecar_path(std::string tape_filepath) {
+	return tape_filepath + ".runs";
+}
+
+bool FileTapeLibrary::RunIndex::is_single_run(std::string tape_filepath, unsigned long long records_count) {
+	auto run_index = RunIndex(tape_filepath, BufferedTape::read);
+
+	// empty tape has no series
+	if (run_index.is_empty()) {
+		return records_count == 0;
+	}
+
+	return run_index.read_next_length() == records_count && run_index.is_empty();
+}
+
+FileTapeLibrary::RunIndex::RunIndex(std::string tape_filepath, BufferedTape::open_mode mode) {
+	filepath = get_sidecar_path(tape_filepath);
+
+	init_mode(mode);
+}
+
+FileTapeLibrary::RunIndex::~RunIndex() {
+	end_current_mode();
+}
+
+void FileTapeLibrary::RunIndex::open(std::string tape_filepath, BufferedTape::open_mode mode) {
+	end_current_mode();
+
+	filepath = get_sidecar_path(tape_filepath);
+	init_mode(mode);
+}
+
+void FileTapeLibrary::RunIndex::close() {
+	end_current_mode();
+}
+
+bool FileTapeLibrary::RunIndex::is_empty() {
+	if (mode != BufferedTape::read) {
+		throw std::exception("run index is not in read mode");
+	}
+
+	if (buffer_position == buffer_size) {
+		read_buffer();
+	}
+
+	return buffer_position == buffer_size;
+}
+
+unsigned long long FileTapeLibrary::RunIndex::read_next_length() {
+	if (is_empty()) {
+		throw std::exception("run index is empty");
+	}
+
+	return buffer[buffer_position++];
+}
+
+void FileTapeLibrary::RunIndex::write_next_length(unsigned long long length) {
+	if (mode != BufferedTape::write) {
+		throw std::exception("run index is not in write mode");
+	}
+
+	if (has_last_length) {
+		// last length can't change anymore
+		if (buffer_size == BUFFER_LENGTHS) {
+			write_buffer();
+		}
+		buffer[buffer_size++] = last_length;
+	}
+
+	has_last_length = true;
+	last_length = length;
+}
+
+void FileTapeLibrary::RunIndex::extend_last_length(unsigned long long length) {
+	if (mode != BufferedTape::write) {
+		throw std::exception("run index is not in write mode");
+	}
+	if (!has_last_length) {
+		throw std::exception("no run has been written");
+	}
+
+	last_length += length;
+}
+
+unsigned long long FileTapeLibrary::RunIndex::get_page_operations() const {
+	return page_operations;
+}
+
+void FileTapeLibrary::RunIndex::end_current_mode() {
+	if (mode == BufferedTape::read) {
+		in.close();
+	}
+	else if (mode == BufferedTape::write) {
+		if (has_last_length) {
+			if (buffer_size == BUFFER_LENGTHS) {
+				write_buffer();
+			}
+			buffer[buffer_size++] = last_length;
+			has_last_length = false;
+		}
+		if (buffer_size > 0) {
+			write_buffer();
+		}
+		out.close();
+	}
+
+	mode = BufferedTape::none;
+}
+
+void FileTapeLibrary::RunIndex::init_mode(BufferedTape::open_mode mode) {
+	this->mode = mode;
+	buffer_size = 0;
+	buffer_position = 0;
+	has_last_length = false;
+
+	if (mode == BufferedTape::read) {
+		in.open(filepath, std::fstream::binary);
+	}
+	else if (mode == BufferedTape::write) {
+		out.open(filepath, std::fstream::binary);
+	}
+}
+
+void FileTapeLibrary::RunIndex::read_buffer() {
+	buffer_position = 0;
+	buffer_size = 0;
+
+	if (!in.is_open() || in.eof()) {
+		return;
+	}
+
+	in.read(reinterpret_cast<char*>(buffer.data()), sizeof(buffer));
+	++page_operations;
+
+	buffer_size = static_cast<std::size_t>(in.gcount()) / sizeof(unsigned long long);
+}
+
+void FileTapeLibrary::RunIndex::write_buffer() {
+	out.write(reinterpret_cast<const char*>(buffer.data()), buffer_size * sizeof(unsigned long long));
+	++page_operations;
+	// buffer is now empty
+	buffer_size = 0;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <fstream>
+#include <string>
+
+#include "Tape.h"
+
+namespace FileTapeLibrary {
+	// sidecar file of a tape, which keeps lengths of consecutive runs (series) written on the tape
+	// with exact lengths runs don't have to be detected by comparing records
+	class RunIndex {
+	public:
+		// how many lengths are read from (or written to) file at once
+		static constexpr std::size_t BUFFER_LENGTHS = 512;
+
+		// sidecar of tape is stored next to it
+		static std::string get_sidecar_path(std::string tape_filepath);
+		// tells if run index of tape says that all records_count records of the tape are one series
+		// (sorts write such run index for their output)
+		static bool is_single_run(std::string tape_filepath, unsigned long long records_count);
+
+		RunIndex(std::string tape_filepath, BufferedTape::open_mode mode = BufferedTape::none);
+		~RunIndex();
+
+		void open(std::string tape_filepath, BufferedTape::open_mode mode);
+		void close();
+
+		/* for read mode only */
+		// check if all lengths have been read
+		bool is_empty();
+		unsigned long long read_next_length();
+
+		/* for write mode only */
+		void write_next_length(unsigned long long length);
+		// add records to last written run (used when series are joining)
+		void extend_last_length(unsigned long long length);
+
+		unsigned long long get_page_operations() const;
+
+	private:
+		void end_current_mode();
+		void init_mode(BufferedTape::open_mode mode);
+		// read lengths from file
+		void read_buffer();
+		// write lengths to file
+		void write_buffer();
+
+		BufferedTape::open_mode mode = BufferedTape::none;
+		std::string filepath;
+		std::ifstream in;
+		std::ofstream out;
+
+		std::array<unsigned long long, BUFFER_LENGTHS> buffer;
+		// in read mode: number of lengths loaded to buffer, in write mode: number of lengths waiting in buffer
+		std::size_t buffer_size = 0;
+		// in read mode: position of next length to read
+		std::size_t buffer_position = 0;
+
+		// last length is kept until next one is written, since it can still be extended
+		bool has_last_length = false;
+		unsigned long long last_length = 0;
+
+		// counter of buffer's outputs or inputs
+		unsigned long long page_operations = 0;
+	};
+}
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <memory>
+
+#include "ShardedSort.h"
+#include "ArrayRecord.h"
+#include "RunIndex.h"
+#include "Tape.h"
+
+namespace {
+	// replaces all occurrences of pattern in text
+	std::string replace_all(std::string text, const std::string& pattern, const std::string& replacement) {
+		auto position = text.find(pattern);
+
+		while (position != std::string::npos) {
+			text.replace(position, pattern.size(), replacement);
+			position = text.find(pattern, position + replacement.size());
+		}
+
+		return text;
+	}
+}
+
+std::vector<int> FileTapeLibrary::sample_splitters(std::string input_path, std::size_t workers_count, std::size_t sample_size, unsigned int seed) {
+	if (workers_count == 0) {
+		throw std::exception("Number of workers must be positive");
+	}
+
+	auto records_count = static_cast<unsigned long long>(std::filesystem::file_size(input_path) / sizeof(ArrayRecord));
+	// nothing to sample - all shards stay empty, whatever splitters are
+	if (records_count == 0) {
+		return std::vector<int>(workers_count - 1, std::numeric_limits<int>::max());
+	}
+
+	// sampled records are read in order of their positions on tape
+	auto engine = std::mt19937(seed);
+	auto position_distribution = std::uniform_int_distribution<unsigned long long>(0, records_count - 1);
+	auto positions = std::vector<unsigned long long>(std::max(sample_size, workers_count));
+	std::generate(positions.begin(), positions.end(), [&]() { return position_distribution(engine); });
+	std::sort(positions.begin(), positions.end());
+
+	auto input = std::ifstream(input_path, std::ios::binary);
+	auto keys = std::vector<int>();
+	keys.reserve(positions.size());
+
+	auto record = ArrayRecord();
+	for (auto position : positions) {
+		input.seekg(static_cast<std::streamoff>(position * sizeof(ArrayRecord)));
+		input.read(reinterpret_cast<char*>(&record), sizeof(ArrayRecord));
+		if (input.gcount() != static_cast<std::streamsize>(sizeof(ArrayRecord))) {
+			throw std::exception("Could not read sampled record");
+		}
+		keys.push_back(record.max());
+	}
+
+	// splitters are quantiles of sampled keys
+	std::sort(keys.begin(), keys.end());
+
+	auto splitters = std::vector<int>();
+	for (std::size_t i = 1; i < workers_count; ++i) {
+		splitters.push_back(keys[i * keys.size() / workers_count]);
+	}
+
+	return splitters;
+}
+
+unsigned long long FileTapeLibrary::partition_tape(std::string input_path, const std::vector<std::string>& shard_paths, const std::vector<int>& splitters) {
+	if (shard_paths.size() != splitters.size() + 1) {
+		throw std::exception("Number of shards must be greater by one than number of splitters");
+	}
+
+	auto input = Tape(input_path, Tape::read);
+	auto shards = std::vector<std::unique_ptr<Tape>>();
+	for (const auto& shard_path : shard_paths) {
+		shards.push_back(std::make_unique<Tape>(shard_path, Tape::write));
+	}
+
+	while (!input.is_empty()) {
+		const auto& record = input.read_next_record();
+		auto shard_id = std::lower_bound(splitters.begin(), splitters.end(), record.max()) - splitters.begin();
+		shards[shard_id]->write_next_record(record);
+	}
+
+	input.close();
+	auto page_operations = input.get_page_operations();
+	for (auto& shard : shards) {
+		shard->close();
+		page_operations += shard->get_page_operations();
+	}
+
+	return page_operations;
+}
+
+unsigned long long FileTapeLibrary::concatenate_tapes(const std::vector<std::string>& input_paths, std::string output_path) {
+	auto output = Tape(output_path, Tape::write);
+	auto page_operations = 0ull;
+
+	for (const auto& input_path : input_paths) {
+		auto input = Tape(input_path, Tape::read);
+
+		while (!input.is_empty()) {
+			output.write_next_record(input.read_next_record());
+		}
+
+		input.close();
+		page_operations += input.get_page_operations();
+	}
+
+	output.close();
+	return page_operations + output.get_page_operations();
+}
+
+unsigned long long FileTapeLibrary::sharded_sort(std::string input_path, std::string output_path, const ShardedSortOptions& options) {
+	auto splitters = sample_splitters(input_path, options.workers_count, options.sample_size, options.seed);
+
+	auto shard_directory = std::filesystem::path(options.shared_directory);
+	auto shard_paths = std::vector<std::string>();
+	auto sorted_shard_paths = std::vector<std::string>();
+	auto scratch_directories = std::vector<std::string>();
+
+	for (std::size_t i = 0; i < options.workers_count; ++i) {
+		auto shard_name = "shard" + std::to_string(i);
+		shard_paths.push_back((shard_directory / (shard_name + ".dat")).string());
+		sorted_shard_paths.push_back((shard_directory / (shard_name + "_sorted.dat")).string());
+		scratch_directories.push_back((shard_directory / (shard_name + "_scratch")).string());
+	}
+
+	// files of shards are removed whether the sort succeeds or not - failed removal doesn't hide error of the sort
+	auto remove_shard_files = [&]() {
+		auto error = std::error_code();
+		for (std::size_t i = 0; i < options.workers_count; ++i) {
+			std::filesystem::remove(shard_paths[i], error);
+			std::filesystem::remove(RunIndex::get_sidecar_path(sorted_shard_paths[i]), error);
+			std::filesystem::remove(sorted_shard_paths[i], error);
+			std::filesystem::remove_all(scratch_directories[i], error);
+		}
+	};
+
+	try {
+		for (const auto& scratch_directory : scratch_directories) {
+			std::filesystem::create_directories(scratch_directory);
+		}
+
+		auto page_operations = partition_tape(input_path, shard_paths, splitters);
+
+		// every worker is waited for by its own thread
+		auto workers = std::vector<std::future<int>>();
+		for (std::size_t i = 0; i < options.workers_count; ++i) {
+			auto command = options.worker_command;
+			command = replace_all(command, "{input}", shard_paths[i]);
+			command = replace_all(command, "{output}", sorted_shard_paths[i]);
+			command = replace_all(command, "{scratch}", scratch_directories[i]);
+
+			if (!options.hosts.empty()) {
+				command = options.hosts[i % options.hosts.size()] + " " + command;
+			}
+
+#if defined(_WIN32)
+			// cmd /c strips the first and the last quote of a command with more quotes - extra pair keeps command intact
+			command = "\"" + command + "\"";
+#endif
+
+			workers.push_back(std::async(std::launch::async, [command]() { return std::system(command.c_str()); }));
+		}
+
+		// all workers are waited for before failure is reported
+		auto failed_workers = 0;
+		for (auto& worker : workers) {
+			if (worker.get() != 0) {
+				++failed_workers;
+			}
+		}
+
+		if (failed_workers > 0) {
+			throw std::exception("Worker failed to sort its shard");
+		}
+
+		// shards hold disjoint ascending key ranges - joined they are sorted
+		page_operations += concatenate_tapes(sorted_shard_paths, output_path);
+
+		// sorted file is one series
+		auto records_count = static_cast<unsigned long long>(std::filesystem::file_size(output_path) / sizeof(ArrayRecord));
+		auto output_run_index = RunIndex(output_path, Tape::write);
+		if (records_count > 0) {
+			output_run_index.write_next_length(records_count);
+		}
+		output_run_index.close();
+		page_operations += output_run_index.get_page_operations();
+
+		remove_shard_files();
+		return page_operations;
+	}
+	catch (...) {
+		remove_shard_files();
+		throw;
+	}
+}
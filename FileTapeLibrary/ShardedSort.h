@@ -0,0 +1,46 @@
+#pragma once
+#include <random>
+#include <string>
+#include <vector>
+
+namespace FileTapeLibrary {
+	/*
+	 * sharded sort splits one tape into shards of disjoint key ranges and sorts them in separate processes
+	 * - splitters are maximal keys (ArrayRecord::max) sampled from input tape
+	 * - coordinator partitions input tape into shards - shard i gets keys from (splitter i-1, splitter i]
+	 * - every shard is sorted by worker process with polyphase merge sort
+	 * - sorted shards are concatenated into output tape
+	 *
+	 * coordinator and workers exchange only files, so all paths must lie on a filesystem shared by them
+	 */
+	struct ShardedSortOptions {
+		// number of shards (and worker processes)
+		std::size_t workers_count = 2;
+		// command which sorts one shard, run by shell (std::system - on Windows it is wrapped in one more pair of quotes for cmd)
+		// {input}, {output} and {scratch} are replaced with shard's input tape, output tape and scratch directory
+		std::string worker_command = "\"Shard worker\" \"{input}\" \"{output}\" \"{scratch}\"";
+		// prefixes of worker commands (e.g. "ssh host1") - shards are given to hosts in turns
+		// no hosts - workers are run on local host
+		std::vector<std::string> hosts;
+		// directory for shards - shared by coordinator and workers
+		std::string shared_directory = "./data";
+		// number of records sampled to choose splitters
+		std::size_t sample_size = 4096;
+		unsigned int seed = std::mt19937::default_seed;
+	};
+
+	// returns workers_count - 1 ascending splitters chosen from max keys of sampled records
+	std::vector<int> sample_splitters(std::string input_path, std::size_t workers_count, std::size_t sample_size, unsigned int seed = std::mt19937::default_seed);
+
+	// record goes to the first shard which splitter is not less than its max key (last shard has no splitter)
+	// returns number of disc operations
+	unsigned long long partition_tape(std::string input_path, const std::vector<std::string>& shard_paths, const std::vector<int>& splitters);
+
+	// writes tapes one after another to output tape
+	// returns number of disc operations
+	unsigned long long concatenate_tapes(const std::vector<std::string>& input_paths, std::string output_path);
+
+	// sorts input tape ascending by max keys
+	// returns number of disc operations done by coordinator (workers report theirs themselves)
+	unsigned long long sharded_sort(std::string input_path, std::string output_path, const ShardedSortOptions& options = ShardedSortOptions());
+}
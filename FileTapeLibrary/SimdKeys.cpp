@@ -0,0 +1,166 @@
+#include "SimdKeys.h"
+#include "SimdMax.h"
+#include "SimdTarget.h"
+
+namespace {
+	typedef std::size_t (*find_descent_function)(const int* keys, std::size_t count);
+	typedef std::size_t (*select_in_range_function)(const int* keys, std::size_t count, int low, int high, std::uint32_t* selection);
+
+	std::size_t find_descent_scalar(const int* keys, std::size_t count, std::size_t begin) {
+		for (auto i = begin; i + 1 < count; ++i) {
+			if (keys[i] > keys[i + 1]) {
+				return i;
+			}
+		}
+
+		return count;
+	}
+
+	std::size_t find_descent_scalar(const int* keys, std::size_t count) {
+		return find_descent_scalar(keys, count, 0);
+	}
+
+	std::size_t select_in_range_scalar(const int* keys, std::size_t count, int low, int high, std::uint32_t* selection, std::size_t begin) {
+		auto selected = std::size_t(0);
+
+		for (auto i = begin; i < count; ++i) {
+			// written without branch - keys are usually random
+			selection[selected] = static_cast<std::uint32_t>(i);
+			selected += (keys[i] >= low) & (keys[i] <= high);
+		}
+
+		return selected;
+	}
+
+	std::size_t select_in_range_scalar(const int* keys, std::size_t count, int low, int high, std::uint32_t* selection) {
+		return select_in_range_scalar(keys, count, low, high, selection, 0);
+	}
+
+#if defined(FILE_TAPE_LIBRARY_X86)
+	/*
+	 * vector implementations compare whole vectors, the rest of keys is done by scalar implementation
+	 * - descent: keys[i..i+w) are compared with keys[i+1..i+w+1), pair found in vector is located by scalar loop
+	 * - selection: mask of lanes out of range is turned into bits, positions are written for set bits
+	 */
+
+	TARGET_SSE41
+	std::size_t find_descent_sse41(const int* keys, std::size_t count) {
+		auto i = std::size_t(0);
+
+		for (; i + 5 <= count; i += 4) {
+			auto current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+			auto next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i + 1));
+
+			if (_mm_movemask_epi8(_mm_cmpgt_epi32(current, next)) != 0) {
+				return find_descent_scalar(keys, i + 5, i);
+			}
+		}
+
+		return find_descent_scalar(keys, count, i);
+	}
+
+	TARGET_SSE41
+	std::size_t select_in_range_sse41(const int* keys, std::size_t count, int low, int high, std::uint32_t* selection) {
+		auto low_vector = _mm_set1_epi32(low);
+		auto high_vector = _mm_set1_epi32(high);
+		auto selected = std::size_t(0);
+		auto i = std::size_t(0);
+
+		for (; i + 4 <= count; i += 4) {
+			auto values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+			auto out_of_range = _mm_or_si128(_mm_cmpgt_epi32(low_vector, values), _mm_cmpgt_epi32(values, high_vector));
+			auto bits = ~_mm_movemask_ps(_mm_castsi128_ps(out_of_range)) & 0xF;
+
+			while (bits != 0) {
+				auto lane = 0;
+				while (((bits >> lane) & 1) == 0) {
+					++lane;
+				}
+				selection[selected++] = static_cast<std::uint32_t>(i + lane);
+				bits &= bits - 1;
+			}
+		}
+
+		return selected + select_in_range_scalar(keys, count, low, high, selection + selected, i);
+	}
+
+	TARGET_AVX2
+	std::size_t find_descent_avx2(const int* keys, std::size_t count) {
+		auto i = std::size_t(0);
+
+		for (; i + 9 <= count; i += 8) {
+			auto current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+			auto next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i + 1));
+
+			if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(current, next)) != 0) {
+				return find_descent_scalar(keys, i + 9, i);
+			}
+		}
+
+		return find_descent_scalar(keys, count, i);
+	}
+
+	TARGET_AVX2
+	std::size_t select_in_range_avx2(const int* keys, std::size_t count, int low, int high, std::uint32_t* selection) {
+		auto low_vector = _mm256_set1_epi32(low);
+		auto high_vector = _mm256_set1_epi32(high);
+		auto selected = std::size_t(0);
+		auto i = std::size_t(0);
+
+		for (; i + 8 <= count; i += 8) {
+			auto values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+			auto out_of_range = _mm256_or_si256(_mm256_cmpgt_epi32(low_vector, values), _mm256_cmpgt_epi32(values, high_vector));
+			auto bits = ~_mm256_movemask_ps(_mm256_castsi256_ps(out_of_range)) & 0xFF;
+
+			while (bits != 0) {
+				auto lane = 0;
+				while (((bits >> lane) & 1) == 0) {
+					++lane;
+				}
+				selection[selected++] = static_cast<std::uint32_t>(i + lane);
+				bits &= bits - 1;
+			}
+		}
+
+		return selected + select_in_range_scalar(keys, count, low, high, selection + selected, i);
+	}
+#endif
+
+	find_descent_function get_find_descent_function() {
+#if defined(FILE_TAPE_LIBRARY_X86)
+		switch (FileTapeLibrary::simd::get_instruction_set()) {
+		case FileTapeLibrary::simd::instruction_set::avx2:
+			return find_descent_avx2;
+		case FileTapeLibrary::simd::instruction_set::sse41:
+			return find_descent_sse41;
+		default:
+			break;
+		}
+#endif
+		return find_descent_scalar;
+	}
+
+	select_in_range_function get_select_in_range_function() {
+#if defined(FILE_TAPE_LIBRARY_X86)
+		switch (FileTapeLibrary::simd::get_instruction_set()) {
+		case FileTapeLibrary::simd::instruction_set::avx2:
+			return select_in_range_avx2;
+		case FileTapeLibrary::simd::instruction_set::sse41:
+			return select_in_range_sse41;
+		default:
+			break;
+		}
+#endif
+		return select_in_range_scalar;
+	}
+}
+
+std::size_t FileTapeLibrary::simd::find_descent(const int* keys, std::size_t count) {
+	static const auto function = get_find_descent_function();
+	return function(keys, count);
+}
+
+std::size_t FileTapeLibrary::simd::select_in_range(const int* keys, std::size_t count, int low, int high, std::uint32_t* selection) {
+	static const auto function = get_select_in_range_function();
+	return function(keys, count, low, high, selection);
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace FileTapeLibrary {
+	namespace simd {
+		// operations on columns of int keys - vectorized with the same instruction set as max (see SimdMax.h)
+
+		// position i of the first pair with keys[i] > keys[i + 1], count if keys are non-decreasing
+		std::size_t find_descent(const int* keys, std::size_t count);
+
+		// writes positions of keys from [low, high] to selection (which must have place for count positions)
+		// returns number of selected positions
+		std::size_t select_in_range(const int* keys, std::size_t count, int low, int high, std::uint32_t* selection);
+	}
+}
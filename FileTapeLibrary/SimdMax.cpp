@@ -0,0 +1,168 @@
+#include <climits>
+
+#include "SimdMax.h"
+#include "SimdTarget.h"
+
+namespace {
+	int max_scalar(const int* data, std::size_t size, std::size_t) {
+		auto max = data[0];
+
+		for (std::size_t i = 1; i < size; ++i) {
+			if (data[i] > max) {
+				max = data[i];
+			}
+		}
+
+		return max;
+	}
+
+#if defined(FILE_TAPE_LIBRARY_X86)
+	/*
+	 * vector implementations go through whole capacity, so their work doesn't depend on size
+	 * (sizes of records are random - branches on them would be mispredicted)
+	 * - vectors are read one after another, the last one ends at the end of capacity
+	 *   (it can overlap with already compared elements, which doesn't change maximum)
+	 * - elements at positions not less than size are masked with the minimal int
+	 * capacity smaller than one vector is handled by narrower implementation
+	 */
+
+	TARGET_SSE41
+	inline __m128i masked_load_sse41(const int* data, std::size_t position, __m128i size) {
+		auto positions = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(position)), _mm_setr_epi32(0, 1, 2, 3));
+		auto mask = _mm_cmpgt_epi32(size, positions);
+		auto values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position));
+		return _mm_blendv_epi8(_mm_set1_epi32(INT_MIN), values, mask);
+	}
+
+	TARGET_SSE41
+	int max_sse41(const int* data, std::size_t size, std::size_t capacity) {
+		if (capacity < 4) {
+			return max_scalar(data, size, capacity);
+		}
+
+		auto size_vector = _mm_set1_epi32(static_cast<int>(size));
+		auto max = masked_load_sse41(data, 0, size_vector);
+		auto i = std::size_t(4);
+		for (; i + 4 <= capacity; i += 4) {
+			max = _mm_max_epi32(max, masked_load_sse41(data, i, size_vector));
+		}
+		if (i < capacity) {
+			max = _mm_max_epi32(max, masked_load_sse41(data, capacity - 4, size_vector));
+		}
+
+		// maximum of 4 lanes
+		max = _mm_max_epi32(max, _mm_shuffle_epi32(max, _MM_SHUFFLE(1, 0, 3, 2)));
+		max = _mm_max_epi32(max, _mm_shuffle_epi32(max, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtsi128_si32(max);
+	}
+
+	TARGET_AVX2
+	inline __m256i masked_load_avx2(const int* data, std::size_t position, __m256i size) {
+		auto positions = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(position)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+		auto mask = _mm256_cmpgt_epi32(size, positions);
+		auto values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + position));
+		return _mm256_blendv_epi8(_mm256_set1_epi32(INT_MIN), values, mask);
+	}
+
+	TARGET_AVX2
+	int max_avx2(const int* data, std::size_t size, std::size_t capacity) {
+		if (capacity < 8) {
+			return max_sse41(data, size, capacity);
+		}
+
+		auto size_vector = _mm256_set1_epi32(static_cast<int>(size));
+		auto max = masked_load_avx2(data, 0, size_vector);
+		auto i = std::size_t(8);
+		for (; i + 8 <= capacity; i += 8) {
+			max = _mm256_max_epi32(max, masked_load_avx2(data, i, size_vector));
+		}
+		if (i < capacity) {
+			max = _mm256_max_epi32(max, masked_load_avx2(data, capacity - 8, size_vector));
+		}
+
+		// maximum of 8 lanes
+		auto half = _mm_max_epi32(_mm256_castsi256_si128(max), _mm256_extracti128_si256(max, 1));
+		half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+		half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtsi128_si32(half);
+	}
+
+	// registers of cpuid instruction
+	struct cpuid_result {
+		unsigned int eax, ebx, ecx, edx;
+	};
+
+	cpuid_result cpuid(unsigned int leaf) {
+		auto result = cpuid_result();
+#if defined(_MSC_VER)
+		int registers[4];
+		__cpuidex(registers, static_cast<int>(leaf), 0);
+		result = { unsigned(registers[0]), unsigned(registers[1]), unsigned(registers[2]), unsigned(registers[3]) };
+#else
+		__asm__ __volatile__("cpuid" : "=a"(result.eax), "=b"(result.ebx), "=c"(result.ecx), "=d"(result.edx) : "a"(leaf), "c"(0));
+#endif
+		return result;
+	}
+
+	// operating system saves ymm registers on context switch
+	bool is_avx_enabled_by_os() {
+#if defined(_MSC_VER)
+		return (_xgetbv(0) & 0x6) == 0x6;
+#else
+		unsigned int eax, edx;
+		__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (eax & 0x6) == 0x6;
+#endif
+	}
+
+	FileTapeLibrary::simd::instruction_set detect_instruction_set() {
+		using FileTapeLibrary::simd::instruction_set;
+
+		if (cpuid(0).eax < 1) {
+			return instruction_set::scalar;
+		}
+
+		auto features = cpuid(1);
+		auto has_sse41 = (features.ecx & (1u << 19)) != 0;
+		auto has_osxsave = (features.ecx & (1u << 27)) != 0;
+		auto has_avx = (features.ecx & (1u << 28)) != 0;
+
+		if (has_osxsave && has_avx && is_avx_enabled_by_os() && cpuid(0).eax >= 7) {
+			auto has_avx2 = (cpuid(7).ebx & (1u << 5)) != 0;
+			if (has_avx2) {
+				return instruction_set::avx2;
+			}
+		}
+
+		return has_sse41 ? instruction_set::sse41 : instruction_set::scalar;
+	}
+#else
+	FileTapeLibrary::simd::instruction_set detect_instruction_set() {
+		return FileTapeLibrary::simd::instruction_set::scalar;
+	}
+#endif
+}
+
+FileTapeLibrary::simd::instruction_set FileTapeLibrary::simd::get_instruction_set() {
+	static const auto set = detect_instruction_set();
+	return set;
+}
+
+FileTapeLibrary::simd::max_function FileTapeLibrary::simd::get_max_function(instruction_set set) {
+#if defined(FILE_TAPE_LIBRARY_X86)
+	switch (set) {
+	case instruction_set::avx2:
+		return max_avx2;
+	case instruction_set::sse41:
+		return max_sse41;
+	default:
+		break;
+	}
+#endif
+	return max_scalar;
+}
+
+int FileTapeLibrary::simd::max(const int* data, std::size_t size, std::size_t capacity) {
+	static const auto function = get_max_function();
+	return function(data, size, capacity);
+}
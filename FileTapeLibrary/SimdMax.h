@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+
+namespace FileTapeLibrary {
+	namespace simd {
+		// instruction sets which maximum can be computed with
+		enum class instruction_set { scalar, sse41, avx2 };
+
+		// maximum of first size (at least 1) ints of data
+		// all capacity (not less than size) ints of data must be readable - vector implementations
+		// read them all and mask elements which are out of size, instead of branching on size
+		typedef int (*max_function)(const int* data, std::size_t size, std::size_t capacity);
+
+		// best instruction set supported by processor (and operating system) - checked once, at first call
+		instruction_set get_instruction_set();
+		// implementation of maximum for given instruction set (scalar if set is not available in this build)
+		max_function get_max_function(instruction_set set = get_instruction_set());
+
+		// maximum with best available implementation
+		int max(const int* data, std::size_t size, std::size_t capacity);
+	}
+}
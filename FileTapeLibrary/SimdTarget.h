@@ -0,0 +1,18 @@
+#pragma once
+
+// internal header of translation units with simd kernels - not included by FileTapeLibrary.h
+// FILE_TAPE_LIBRARY_X86 is defined when x86 intrinsics are available
+// TARGET_SSE41 and TARGET_AVX2 mark functions compiled for these instruction sets (chosen at runtime)
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FILE_TAPE_LIBRARY_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// msvc compiles intrinsics of all instruction sets without additional flags
+#define TARGET_SSE41
+#define TARGET_AVX2
+#else
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
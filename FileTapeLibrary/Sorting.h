@@ -0,0 +1,749 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "Combiner.h"
+#include "FileTapeLibrary.h"
+#include "KeyedTape.h"
+#include "KeyOffsetRecord.h"
+#include "RadixSort.h"
+#include "RunIndex.h"
+#include "SortingPolicy.h"
+
+namespace FileTapeLibrary {
+	// log which ignores everything - used when sort is not logged
+	struct NullLog {
+		template <typename T>
+		const NullLog& operator<<(const T&) const {
+			return *this;
+		}
+
+		const NullLog& operator<<(std::ostream& (*)(std::ostream&)) const {
+			return *this;
+		}
+	};
+
+	template <typename Record>
+	void log_file(const NullLog&, const std::string&) {}
+
+	template <typename Record>
+	void log_file(std::ostream& log, const std::string& filepath) {
+		auto tape = BasicTape<Record>(filepath, BufferedTape::read);
+
+		while (!tape.is_empty()) {
+			log << tape.read_next_record() << '\n';
+		}
+	}
+
+	// sorting_policy is either sorting policy (see SortingPolicy.h) or comparator of two records
+	template <typename Policy>
+	bool is_sorted(std::string filepath, const Policy& sorting_policy) {
+		auto tape = KeyedTape<sorting_policy_t<Policy>>(filepath, Tape::read, make_sorting_policy(sorting_policy));
+
+		while (!tape.is_empty()) {
+			tape.read_next_record();
+
+			if (!tape.is_progressing()) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// splits tape into sorted runs of (at most) run_length records, sorted in memory by int keys with radix sort
+	// with combiner (see Combiner.h) records are prepared when they are read and records of equal keys in a run are combined
+	// returns number of disc operations
+	template <typename Record = ArrayRecord, typename KeyExtractor, typename Combiner = NoCombiner>
+	unsigned long long form_runs(
+		std::string input_path,
+		std::string output_path,
+		const KeyExtractor& key_extractor,
+		std::size_t run_length,
+		bool parallel = false,
+		const Combiner& combiner = Combiner()
+	) {
+		static_assert(is_key_extractor_allowed<Combiner, KeyExtractor>(), "records prepared by combiner must be sorted with its required_key_extractor");
+
+		if (run_length == 0) {
+			throw std::exception("Run length must be positive");
+		}
+		// records of run are indexed with 32-bit numbers
+		if (run_length > std::numeric_limits<std::uint32_t>::max()) {
+			throw std::exception("Run length is too big");
+		}
+
+		auto input = BasicTape<Record>(input_path, BufferedTape::read);
+		auto output = BasicTape<Record>(output_path, BufferedTape::write);
+
+		// records of current run (memory is borrowed from BufferPool) and their keys
+		auto records = pooled_vector<Record>();
+		auto keys = std::vector<KeyIndex>();
+		records.reserve(run_length);
+		keys.reserve(run_length);
+
+		// keys of whole run, for extractors which compute keys of blocks of records
+		auto block_keys = std::vector<int>();
+
+		while (!input.is_empty()) {
+			// load run to memory, extracting keys once per record
+			while (records.size() < run_length && !input.is_empty()) {
+				records.push_back(prepare_record(combiner, input.read_next_record()));
+			}
+
+			if constexpr (has_batch_keys<KeyExtractor, Record>::value) {
+				block_keys.resize(records.size());
+				key_extractor(records.data(), records.size(), block_keys.data());
+				for (std::size_t i = 0; i < records.size(); ++i) {
+					keys.push_back({ block_keys[i], static_cast<std::uint32_t>(i) });
+				}
+			}
+			else {
+				for (std::size_t i = 0; i < records.size(); ++i) {
+					keys.push_back({ key_extractor(records[i]), static_cast<std::uint32_t>(i) });
+				}
+			}
+
+			radix_sort(keys, parallel);
+
+			// put records on tape in order of their keys
+			if constexpr (is_combining<Combiner>::value) {
+				for (std::size_t begin = 0; begin < keys.size();) {
+					auto record = records[keys[begin].index];
+					auto end = begin + 1;
+
+					for (; end < keys.size() && keys[end].key == keys[begin].key; ++end) {
+						combiner.combine(record, records[keys[end].index]);
+					}
+
+					output.write_next_record(record);
+					begin = end;
+				}
+			}
+			else {
+				for (const auto& key : keys) {
+					output.write_next_record(records[key.index]);
+				}
+			}
+
+			records.clear();
+			keys.clear();
+		}
+
+		input.close();
+		output.close();
+
+		return input.get_page_operations() + output.get_page_operations();
+	}
+
+	namespace detail {
+		// writes series to keyed tape - with combiner, records of equal keys which come one after another are collapsed,
+		// so record is held until record of different key (or end of series) comes
+		template <typename Policy, typename Combiner>
+		class SeriesWriter {
+		public:
+			typedef typename Policy::record_type record_type;
+			typedef typename Policy::key_type key_type;
+
+			SeriesWriter(const Policy& policy, const Combiner& combiner) : policy(policy), combiner(combiner) {}
+
+			void write(KeyedTape<Policy>& tape, const record_type& record, const key_type& key) {
+				if constexpr (is_combining<Combiner>::value) {
+					// keys are equal if each of them can be placed before the other
+					if (has_held_record && policy(held_key, key) && policy(key, held_key)) {
+						combiner.combine(held_record, record);
+						return;
+					}
+
+					write_held_record(tape);
+					held_record = record;
+					held_key = key;
+					has_held_record = true;
+				}
+				else {
+					tape.write_next_record(record, key);
+					++length;
+				}
+			}
+
+			// returns number of records written in the series and begins next one
+			unsigned long long end_series(KeyedTape<Policy>& tape) {
+				write_held_record(tape);
+				return std::exchange(length, 0ull);
+			}
+
+		private:
+			void write_held_record(KeyedTape<Policy>& tape) {
+				if (has_held_record) {
+					tape.write_next_record(held_record, held_key);
+					has_held_record = false;
+					++length;
+				}
+			}
+
+			const Policy& policy;
+			const Combiner& combiner;
+			record_type held_record = record_type();
+			key_type held_key = key_type();
+			bool has_held_record = false;
+			unsigned long long length = 0;
+		};
+
+		/*
+		 * polyphase merge sort on 3 tapes
+		 *
+		 * distribution phase puts series on tapes 1 and 2 in Fibonacci numbers, level by level,
+		 * spreading series horizontally (Knuth, The Art of Computer Programming vol. 3, 5.4.2, algorithm D)
+		 * series missing to perfect distribution are dummy runs - empty series which exist only as counters
+		 * and are assumed to be placed on the beginning of the tape
+		 *
+		 * merge phase merges series by counts:
+		 * - dummy with dummy gives dummy on output tape (no data is moved)
+		 * - dummy with series gives that series
+		 * - series with series are merged
+		 *
+		 * every tape written by the sort has a run index (see RunIndex.h) with lengths of its series,
+		 * so series are detected by comparing records only once - when input tape is distributed
+		 *
+		 * with combiner (see Combiner.h) every written series has records of equal keys collapsed
+		 * - records of input tape have to be prepared already
+		 */
+		template <typename Policy, typename Combiner, typename Log>
+		std::tuple<unsigned int, unsigned long long> polyphase_merge_sort(
+			std::string input_path, std::string output_path,
+			const Policy& sorting_policy,
+			const Combiner& combiner,
+			const std::string& scratch_directory,
+			Log& log
+		) {
+			typedef typename Policy::record_type record_type;
+
+			log << "------------file before sort------------" << std::endl;
+			log_file<record_type>(log, input_path);
+
+			KeyedTape<Policy> tapes[] = {
+				KeyedTape<Policy>(input_path, Tape::read, sorting_policy),
+				KeyedTape<Policy>(scratch_directory + "/tape1.dat", Tape::write, sorting_policy),
+				KeyedTape<Policy>(scratch_directory + "/tape2.dat", Tape::write, sorting_policy)
+			};
+			RunIndex run_indexes[] = {
+				RunIndex(input_path),
+				RunIndex(tapes[1].get_filepath(), Tape::write),
+				RunIndex(tapes[2].get_filepath(), Tape::write)
+			};
+
+			// number of series on each tape (dummy runs included)
+			// counters are 64-bit - tapes can hold more than 2^31 series
+			unsigned long long series[] = { 0, 0, 0 };
+			// number of dummy runs on each tape
+			unsigned long long dummy_runs[] = { 0, 0, 0 };
+			// number of records on input tape
+			auto records_count = 0ull;
+
+			auto page_operations = [&]() {
+				auto operations = 0ull;
+				for (std::size_t i = 0; i < 3; ++i) {
+					operations += tapes[i].get_page_operations() + run_indexes[i].get_page_operations();
+				}
+				return operations;
+			};
+
+			// sorted file is one series - its run index tells that to the readers
+			auto write_output_run_index = [&](unsigned long long records_count) {
+				auto output_run_index = RunIndex(output_path, Tape::write);
+				if (records_count > 0) {
+					output_run_index.write_next_length(records_count);
+				}
+			};
+
+			/*
+			 * copy series which begins with current record of input tape to output tape
+			 * series ends where records stop progressing
+			 *
+			 * after this function input tape's current record is first record of the next series (or DNE)
+			 * returns length of the series
+			 */
+			auto copy_natural_series = [&](std::size_t output_tape_id) {
+				auto& input_tape = tapes[0];
+				auto& output_tape = tapes[output_tape_id];
+				auto writer = SeriesWriter<Policy, Combiner>(sorting_policy, combiner);
+
+				// current record begins the series
+				input_tape.clear_last_record();
+
+				do {
+					writer.write(output_tape, input_tape.get_current_record(), input_tape.get_current_key());
+					input_tape.read_next_record();
+				}
+				// while series on input tape is progressing
+				while (input_tape.is_progressing());
+
+				return writer.end_series(output_tape);
+			};
+
+			// copy next series of data tape to output tape - length of the series is read from run index
+			auto copy_series = [&](std::size_t data_tape_id, std::size_t output_tape_id) {
+				auto& data_tape = tapes[data_tape_id];
+				auto& output_tape = tapes[output_tape_id];
+
+				auto length = run_indexes[data_tape_id].read_next_length();
+				run_indexes[output_tape_id].write_next_length(length);
+
+				for (auto i = 0ull; i < length; ++i) {
+					output_tape.write_next_record(data_tape.get_current_record(), data_tape.get_current_key());
+					data_tape.read_next_record();
+				}
+			};
+
+			/*
+			 * write one series from input tape to output tape during distribution
+			 * if series joins with the last series on output tape, one more series is written,
+			 * so that output tape has exactly one series more than before
+			 *
+			 * returns false if input ended before series could have been added
+			 * call this function only if input tape has current record
+			 */
+			auto distribute_series = [&](std::size_t output_tape_id) {
+				auto& input_tape = tapes[0];
+				auto& output_tape = tapes[output_tape_id];
+
+				// current record on input tape (which we want to put on output_tape) is in correct order after current record on output_tape
+				auto joined = output_tape.get_current_record().is_valid()
+					&& sorting_policy(output_tape.get_current_key(), input_tape.get_current_key());
+				if constexpr (is_combining<Combiner>::value) {
+					// records of equal keys can't be collapsed over written record - such series are collapsed by merge
+					joined = joined && !sorting_policy(input_tape.get_current_key(), output_tape.get_current_key());
+				}
+
+				auto length = copy_natural_series(output_tape_id);
+				records_count += length;
+
+				if (joined) {
+					log << "series are joining" << std::endl;
+					run_indexes[output_tape_id].extend_last_length(length);
+
+					// next series can't join - it begins with record which broke the joined one
+					if (!input_tape.get_current_record().is_valid()) {
+						return false;
+					}
+					length = copy_natural_series(output_tape_id);
+					records_count += length;
+				}
+
+				run_indexes[output_tape_id].write_next_length(length);
+				return true;
+			};
+
+			// merge next series of each tape into output tape - lengths of series are read from run indexes
+			auto merge_series = [&](std::size_t id1, std::size_t id2, std::size_t output_tape_id) {
+				auto& output_tape = tapes[output_tape_id];
+				auto writer = SeriesWriter<Policy, Combiner>(sorting_policy, combiner);
+
+				// records left in series of each tape
+				auto left1 = run_indexes[id1].read_next_length();
+				auto left2 = run_indexes[id2].read_next_length();
+
+				// merge records until series on one of the tapes ends
+				while (left1 > 0 && left2 > 0) {
+					log << "comparing record " << tapes[id1].get_current_record() << " with " << tapes[id2].get_current_record() << std::endl;
+
+					// choose which tape's record goes first
+					auto save_tape_id = sorting_policy(tapes[id1].get_current_key(), tapes[id2].get_current_key()) ? id1 : id2;
+
+					log << "saving record " << tapes[save_tape_id].get_current_record() << " from tape " << save_tape_id << std::endl;
+					writer.write(output_tape, tapes[save_tape_id].get_current_record(), tapes[save_tape_id].get_current_key());
+
+					// get next record, since we just saved one
+					tapes[save_tape_id].read_next_record();
+
+					--(save_tape_id == id1 ? left1 : left2);
+				}
+
+				// finish series on the other tape
+				auto finish_tape_id = left1 > 0 ? id1 : id2;
+				auto& left = left1 > 0 ? left1 : left2;
+				if (left > 0) {
+					log << "finishing series of tape " << finish_tape_id << std::endl;
+				}
+
+				for (; left > 0; --left) {
+					writer.write(output_tape, tapes[finish_tape_id].get_current_record(), tapes[finish_tape_id].get_current_key());
+					tapes[finish_tape_id].read_next_record();
+				}
+
+				run_indexes[output_tape_id].write_next_length(writer.end_series(output_tape));
+			};
+
+			/* distribution phase */
+
+			// read first record of file
+			if (!tapes[0].is_empty()) {
+				tapes[0].read_next_record();
+			}
+			else {
+				// file has no data - tape sorted
+				copy_file<record_type>(input_path, output_path);
+				write_output_run_index(0);
+				return std::make_tuple(0, page_operations());
+			}
+
+			// perfect distribution on current level - starting with 1 series on each tape, all of them dummy
+			unsigned long long perfect[] = { 0, 1, 1 };
+			series[1] = series[2] = 1;
+			dummy_runs[1] = dummy_runs[2] = 1;
+			auto level = 1;
+			auto output_tape_id = std::size_t(1);
+
+			while (tapes[0].get_current_record().is_valid()) {
+				// replace one dummy run on output tape with actual series
+				if (distribute_series(output_tape_id)) {
+					--dummy_runs[output_tape_id];
+				}
+
+				if (!tapes[0].get_current_record().is_valid()) {
+					break;
+				}
+
+				// choose next tape - fill tape which has more dummy runs
+				if (output_tape_id == 1 && dummy_runs[1] < dummy_runs[2]) {
+					output_tape_id = 2;
+				}
+				else if (dummy_runs[output_tape_id] == 0) {
+					// no dummy runs left - go to next level of Fibonacci distribution
+					auto a = perfect[1];
+					dummy_runs[1] = a + perfect[2] - perfect[1];
+					dummy_runs[2] = a - perfect[2];
+					std::tie(perfect[1], perfect[2]) = std::make_tuple(a + perfect[2], a);
+					series[1] = perfect[1];
+					series[2] = perfect[2];
+					++level;
+					output_tape_id = 1;
+
+					log << "level " << level << " - " << perfect[1] << " and " << perfect[2] << " series" << std::endl;
+				}
+				else {
+					output_tape_id = 1;
+				}
+			}
+
+			log << series[1] << " series (" << dummy_runs[1] << " dummy) on tape 1" << std::endl;
+			log << series[2] << " series (" << dummy_runs[2] << " dummy) on tape 2" << std::endl;
+
+			// tape contained 1 series only
+			if (series[1] + series[2] - dummy_runs[1] - dummy_runs[2] <= 1) {
+				log << "Only one series was on a file" << std::endl;
+				if constexpr (is_combining<Combiner>::value) {
+					// series was collapsed while it was written to tape 1
+					tapes[1].close();
+					copy_file<record_type>(tapes[1].get_filepath(), output_path);
+				}
+				else {
+					copy_file<record_type>(input_path, output_path);
+				}
+				write_output_run_index(records_count);
+				return std::make_tuple(0, page_operations());
+			}
+
+			log << "tapes after distribution phase" << std::endl;
+			// close all tapes
+			for (int i = 0; i < 3; ++i) {
+				tapes[i].close();
+				run_indexes[i].close();
+
+				log << "-----------------tape" << i << "------------------" << std::endl;
+				log_file<record_type>(log, tapes[i].get_filepath());
+			}
+			log << std::endl;
+			/* end of distribution phase */
+
+			/* merge phase */
+			tapes[0].open(output_path, Tape::write);		// change path to prevent overriding input file
+			tapes[1].open(tapes[1].get_filepath(), Tape::read);
+			tapes[2].open(tapes[2].get_filepath(), Tape::read);
+			for (std::size_t i = 0; i < 3; ++i) {
+				run_indexes[i].open(tapes[i].get_filepath(), i == 0 ? Tape::write : Tape::read);
+			}
+
+			// read first records of data tapes
+			for (std::size_t i = 1; i < 3; ++i) {
+				if (!tapes[i].is_empty()) {
+					tapes[i].read_next_record();
+				}
+			}
+
+			// tape 1 has at least as many series as tape 2
+			auto bigger_tape_id = std::size_t(1);
+			auto smaller_tape_id = std::size_t(2);
+			output_tape_id = 0;
+
+			// counter of phases
+			auto phases_count = std::size_t(0);
+
+			while (series[bigger_tape_id] + series[smaller_tape_id] > 1) {
+				log << "merging " << series[smaller_tape_id] << " series of tapes " << bigger_tape_id << " and " << smaller_tape_id << std::endl;
+
+				// all series of smaller tape are merged with the same number of series of bigger tape
+				for (auto merged = 0ull; merged < series[smaller_tape_id]; ++merged) {
+					if (dummy_runs[bigger_tape_id] > 0 && dummy_runs[smaller_tape_id] > 0) {
+						// merge of two dummy runs is dummy run
+						--dummy_runs[bigger_tape_id];
+						--dummy_runs[smaller_tape_id];
+						++dummy_runs[output_tape_id];
+					}
+					else if (dummy_runs[bigger_tape_id] > 0) {
+						--dummy_runs[bigger_tape_id];
+						copy_series(smaller_tape_id, output_tape_id);
+					}
+					else if (dummy_runs[smaller_tape_id] > 0) {
+						--dummy_runs[smaller_tape_id];
+						copy_series(bigger_tape_id, output_tape_id);
+					}
+					else {
+						merge_series(bigger_tape_id, smaller_tape_id, output_tape_id);
+					}
+				}
+
+				series[output_tape_id] = series[smaller_tape_id];
+				series[bigger_tape_id] -= series[smaller_tape_id];
+				series[smaller_tape_id] = 0;
+
+				log << std::endl;
+				log << "tapes after " << phases_count << " phase" << std::endl;
+				log << "-----------------tape" << smaller_tape_id << "------------------" << std::endl;
+				log << "-----------------empty------------------" << std::endl;
+				// switch smaller tape (which is empty now) to write mode
+				tapes[smaller_tape_id].close();
+				tapes[smaller_tape_id].open(tapes[smaller_tape_id].get_filepath(), Tape::write);
+				run_indexes[smaller_tape_id].open(tapes[smaller_tape_id].get_filepath(), Tape::write);
+
+				// switch output tape to read mode
+				tapes[output_tape_id].close();
+				tapes[output_tape_id].open(tapes[output_tape_id].get_filepath(), Tape::read);
+				run_indexes[output_tape_id].open(tapes[output_tape_id].get_filepath(), Tape::read);
+				// we should read first record here
+				if (!tapes[output_tape_id].is_empty()) {
+					tapes[output_tape_id].read_next_record();
+				}
+
+				log << "-----------------tape" << output_tape_id << "------------------" << std::endl;
+				log_file<record_type>(log, tapes[output_tape_id].get_filepath());
+
+				// bigger tape is still opened
+				log << "-----------------tape" << bigger_tape_id << "------------------" << std::endl;
+				log << "-----current record: " << tapes[bigger_tape_id].get_current_record() << "-----" << std::endl;
+				log_file<record_type>(log, tapes[bigger_tape_id].get_filepath());
+
+				log << std::endl;
+
+				// output tape has now at least as many series as rest of bigger tape
+				std::tie(smaller_tape_id, output_tape_id, bigger_tape_id) = std::make_tuple(bigger_tape_id, smaller_tape_id, output_tape_id);
+
+				++phases_count;
+			}
+
+			if constexpr (is_combining<Combiner>::value) {
+				// merges have collapsed records - length of the only series left is in run index
+				records_count = run_indexes[bigger_tape_id].read_next_length();
+			}
+
+			// close all tapes
+			for (int i = 0; i < 3; ++i) {
+				tapes[i].close();
+				run_indexes[i].close();
+			}
+
+			// the only series left is on bigger tape
+			if (tapes[bigger_tape_id].get_filepath() != output_path) {
+				copy_file<record_type>(tapes[bigger_tape_id].get_filepath(), output_path);
+				write_output_run_index(records_count);
+			}
+
+			log << std::endl;
+			log << "sorted file after " << phases_count << " phases" << std::endl;
+			log << "-----------------tape" << bigger_tape_id << "------------------" << std::endl;
+			log_file<record_type>(log, output_path);
+
+			return std::make_tuple(phases_count, page_operations());
+		}
+	}
+
+	// directory of tapes used by sorts for intermediate data
+	constexpr const char* DEFAULT_SCRATCH_DIRECTORY = "./data";
+
+	// sorting_policy is either sorting policy (see SortingPolicy.h) or comparator of two records
+	// scratch_directory holds intermediate tapes - sorts running at the same time need different ones
+	// returns number of phases and number of disc operations
+	template <typename Policy>
+	std::tuple<unsigned int, unsigned long long> polyphase_merge_sort(
+		std::string input_path,
+		std::string output_path,
+		const Policy& sorting_policy,
+		std::string scratch_directory = DEFAULT_SCRATCH_DIRECTORY
+	) {
+		auto log = NullLog();
+		return detail::polyphase_merge_sort(input_path, output_path, make_sorting_policy(sorting_policy), NoCombiner(), scratch_directory, log);
+	}
+
+	// returns number of phases and number of disc operations
+	template <typename Policy>
+	std::tuple<unsigned int, unsigned long long> polyphase_merge_sort(
+		std::string input_path,
+		std::string output_path,
+		const Policy& sorting_policy,
+		std::ostream& log
+	) {
+		return detail::polyphase_merge_sort(input_path, output_path, make_sorting_policy(sorting_policy), NoCombiner(), DEFAULT_SCRATCH_DIRECTORY, log);
+	}
+
+	// runs are formed in memory by radix sort of keys, then merged with polyphase merge sort
+	// combiner (see Combiner.h) collapses records of equal keys when runs are formed and at every merge,
+	// e.g. CountCombiner with KeySortingPolicy<FirstKey> gives one { key, count } record per key
+	// returns number of phases and number of disc operations
+	template <typename KeyExtractor, typename Record, typename Combiner>
+	std::tuple<unsigned int, unsigned long long> polyphase_merge_sort(
+		std::string input_path,
+		std::string output_path,
+		const KeySortingPolicy<KeyExtractor, std::less_equal<>, Record>& sorting_policy,
+		std::size_t run_length,
+		const Combiner& combiner,
+		bool parallel = false
+	) {
+		static_assert(std::is_same<typename KeySortingPolicy<KeyExtractor, std::less_equal<>, Record>::key_type, int>::value, "radix sort requires int keys");
+
+		auto runs_path = std::string(DEFAULT_SCRATCH_DIRECTORY) + "/runs.dat";
+		auto log = NullLog();
+
+		auto runs_page_operations = form_runs<Record>(input_path, runs_path, sorting_policy.get_key_extractor(), run_length, parallel, combiner);
+		auto result = detail::polyphase_merge_sort(runs_path, output_path, sorting_policy, combiner, DEFAULT_SCRATCH_DIRECTORY, log);
+
+		return std::make_tuple(std::get<0>(result), std::get<1>(result) + runs_page_operations);
+	}
+
+	// runs are formed in memory by radix sort of keys, then merged with polyphase merge sort
+	// returns number of phases and number of disc operations
+	template <typename KeyExtractor, typename Record>
+	std::tuple<unsigned int, unsigned long long> polyphase_merge_sort(
+		std::string input_path,
+		std::string output_path,
+		const KeySortingPolicy<KeyExtractor, std::less_equal<>, Record>& sorting_policy,
+		std::size_t run_length,
+		bool parallel = false
+	) {
+		return polyphase_merge_sort(input_path, output_path, sorting_policy, run_length, NoCombiner(), parallel);
+	}
+
+	// how many records are gathered at once by indirect sort
+	constexpr std::size_t INDIRECT_SORT_BATCH_LENGTH = std::size_t(1) << 16;
+
+	/*
+	 * indirect sort for wide records
+	 * - key and offset of every record are put on a tape of keys, which is sorted with polyphase merge sort
+	 *   (KeyOffsetRecord is smaller than wide records, so every phase moves less data)
+	 * - records are gathered to output in order of sorted keys - keys are taken in batches
+	 *   and records of a batch are read from input in order of their offsets
+	 *
+	 * records are ordered by ascending keys
+	 * returns number of phases and number of disc operations
+	 */
+	template <typename Record = ArrayRecord, typename KeyExtractor = MaxKey>
+	std::tuple<unsigned int, unsigned long long> indirect_polyphase_merge_sort(
+		std::string input_path,
+		std::string output_path,
+		const KeyExtractor& key_extractor = KeyExtractor(),
+		std::size_t batch_length = INDIRECT_SORT_BATCH_LENGTH
+	) {
+		if (batch_length == 0) {
+			throw std::exception("Batch length must be positive");
+		}
+
+		auto keys_path = std::string(DEFAULT_SCRATCH_DIRECTORY) + "/keys.dat";
+		auto sorted_keys_path = std::string(DEFAULT_SCRATCH_DIRECTORY) + "/sorted_keys.dat";
+		auto page_operations = 0ull;
+
+		/* put keys on tape */
+		{
+			auto input = BasicTape<Record>(input_path, BufferedTape::read);
+			auto keys = BasicTape<KeyOffsetRecord>(keys_path, BufferedTape::write);
+			auto offset = offset_t(0);
+
+			while (!input.is_empty()) {
+				keys.write_next_record(KeyOffsetRecord{ key_extractor(input.read_next_record()), offset });
+				offset += sizeof(Record);
+			}
+
+			input.close();
+			keys.close();
+			page_operations += input.get_page_operations() + keys.get_page_operations();
+		}
+
+		/* sort keys */
+		auto result = polyphase_merge_sort(keys_path, sorted_keys_path, KeySortingPolicy<OffsetRecordKey, std::less_equal<>, KeyOffsetRecord>());
+		page_operations += std::get<1>(result);
+
+		/* gather records */
+		auto sorted_keys = BasicTape<KeyOffsetRecord>(sorted_keys_path, BufferedTape::read);
+		auto output = BasicTape<Record>(output_path, BufferedTape::write);
+		auto input_file = std::ifstream(input_path, std::ios::binary);
+
+		// offsets of records in batch with their positions in output
+		auto batch = std::vector<std::pair<offset_t, std::size_t>>();
+		// records of batch in output order
+		auto records = pooled_vector<Record>(batch_length);
+		// records read at once - adjacent in input file
+		auto span = pooled_vector<Record>(batch_length);
+		auto records_count = 0ull;
+		batch.reserve(batch_length);
+
+		while (!sorted_keys.is_empty()) {
+			batch.clear();
+			while (batch.size() < batch_length && !sorted_keys.is_empty()) {
+				batch.emplace_back(sorted_keys.read_next_record().offset, batch.size());
+			}
+
+			std::sort(batch.begin(), batch.end());
+
+			for (std::size_t begin = 0; begin < batch.size();) {
+				// find records which lie one after another in input file
+				auto end = begin + 1;
+				while (end < batch.size() && batch[end].first == batch[end - 1].first + sizeof(Record)) {
+					++end;
+				}
+
+				input_file.seekg(static_cast<std::streamoff>(batch[begin].first));
+				input_file.read(reinterpret_cast<char*>(span.data()), (end - begin) * sizeof(Record));
+				if (static_cast<std::size_t>(input_file.gcount()) != (end - begin) * sizeof(Record)) {
+					throw std::exception("Record is beyond end of input file");
+				}
+				++page_operations;
+
+				for (auto i = begin; i < end; ++i) {
+					records[batch[i].second] = span[i - begin];
+				}
+
+				begin = end;
+			}
+
+			for (std::size_t i = 0; i < batch.size(); ++i) {
+				output.write_next_record(records[i]);
+			}
+			records_count += batch.size();
+		}
+
+		sorted_keys.close();
+		output.close();
+		page_operations += sorted_keys.get_page_operations() + output.get_page_operations();
+
+		// sorted file is one series
+		auto output_run_index = RunIndex(output_path, BufferedTape::write);
+		if (records_count > 0) {
+			output_run_index.write_next_length(records_count);
+		}
+
+		return std::make_tuple(std::get<0>(result), page_operations);
+	}
+}
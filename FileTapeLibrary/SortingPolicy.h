@@ -0,0 +1,129 @@
+#pragma once
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "ArrayRecord.h"
+
+namespace FileTapeLibrary {
+	// key used by default - maximal element of the record
+	struct MaxKey {
+		template <std::size_t N>
+		int operator()(const BasicArrayRecord<N>& ar) const {
+			return ar.max();
+		}
+
+		// keys of a block of records at once
+		template <std::size_t N>
+		void operator()(const BasicArrayRecord<N>* records, std::size_t count, int* keys) const {
+			BasicArrayRecord<N>::max_keys(records, count, keys);
+		}
+	};
+
+	// first element of the record - key of records prepared by combiners (see Combiner.h)
+	struct FirstKey {
+		template <std::size_t N>
+		int operator()(const BasicArrayRecord<N>& ar) const {
+			return ar[0];
+		}
+	};
+
+	/*
+	 * sorting policy is a type which:
+	 * - defines record_type - type of sorted records
+	 * - defines key_type
+	 * - computes key of the record with key(record)
+	 * - tells with operator()(key1, key2) if record of key1 can be placed before record of key2
+	 * keys are computed once per record read from tape and kept next to it (see KeyedTape)
+	 */
+
+	// compares records by keys extracted from them
+	template <typename KeyExtractor = MaxKey, typename Compare = std::less_equal<>, typename Record = ArrayRecord>
+	class KeySortingPolicy {
+	public:
+		typedef Record record_type;
+		typedef std::decay_t<std::invoke_result_t<const KeyExtractor&, const Record&>> key_type;
+
+		KeySortingPolicy(KeyExtractor key_extractor = KeyExtractor(), Compare compare = Compare())
+			: key_extractor(std::move(key_extractor)), compare(std::move(compare)) {}
+
+		key_type key(const Record& record) const {
+			return key_extractor(record);
+		}
+
+		const KeyExtractor& get_key_extractor() const {
+			return key_extractor;
+		}
+
+		bool operator()(const key_type& key1, const key_type& key2) const {
+			return compare(key1, key2);
+		}
+
+	private:
+		KeyExtractor key_extractor;
+		Compare compare;
+	};
+
+	// compares whole records with comparator - key of the record is the record itself
+	template <typename Comparator, typename Record = ArrayRecord>
+	class RecordSortingPolicy {
+	public:
+		typedef Record record_type;
+		typedef Record key_type;
+
+		RecordSortingPolicy(Comparator comparator) : comparator(std::move(comparator)) {}
+
+		const Record& key(const Record& record) const {
+			return record;
+		}
+
+		bool operator()(const Record& record1, const Record& record2) const {
+			return comparator(record1, record2);
+		}
+
+	private:
+		Comparator comparator;
+	};
+
+	// sorting policy which counts comparisons of keys - copies of the policy (e.g. kept by tapes) share the counter
+	template <typename Policy>
+	class CountingSortingPolicy : public Policy {
+	public:
+		typedef typename Policy::record_type record_type;
+		typedef typename Policy::key_type key_type;
+
+		CountingSortingPolicy(Policy policy, unsigned long long& comparisons) : Policy(std::move(policy)), comparisons(&comparisons) {}
+
+		bool operator()(const key_type& key1, const key_type& key2) const {
+			++*comparisons;
+			return Policy::operator()(key1, key2);
+		}
+
+	private:
+		unsigned long long* comparisons;
+	};
+
+	// key extractor can compute keys of a block of records at once
+	template <typename KeyExtractor, typename Record = ArrayRecord>
+	struct has_batch_keys : std::is_invocable<const KeyExtractor&, const Record*, std::size_t, int*> {};
+
+	template <typename T, typename = void>
+	struct is_sorting_policy : std::false_type {};
+
+	template <typename T>
+	struct is_sorting_policy<T, std::void_t<typename T::key_type>> : std::true_type {};
+
+	// sorting policies are passed through, plain comparators of records (functions, lambdas) are wrapped
+	template <typename Policy>
+	auto make_sorting_policy(const Policy& policy) {
+		if constexpr (is_sorting_policy<Policy>::value) {
+			return policy;
+		}
+		else {
+			return RecordSortingPolicy<std::decay_t<Policy>>(policy);
+		}
+	}
+
+	template <typename Policy>
+	using sorting_policy_t = decltype(make_sorting_policy(std::declval<const Policy&>()));
+}
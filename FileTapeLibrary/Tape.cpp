@@ -1,48 +1,41 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
 #include "Tape.h"
 
-FileTapeLibrary::Tape::Tape(std::string filepath, open_mode mode) {
+namespace {
+	std::atomic<std::size_t> buffer_size_setting(FileTapeLibrary::BufferedTape::DEFAULT_BUFFER_SIZE);
+}
+
+FileTapeLibrary::BufferedTape::BufferedTape(std::string filepath, open_mode mode)
+	: buffer(buffer_size_setting.load()), buffer_size(buffer.size()) {
 	this->filepath = filepath;
 	page_operations = 0;
 
 	init_mode(mode);
 }
 
-FileTapeLibrary::Tape::~Tape() {
+FileTapeLibrary::BufferedTape::~BufferedTape() {
 	end_current_mode();
 }
 
-FileTapeLibrary::ArrayRecord FileTapeLibrary::Tape::read_next_record() {
-	if (mode != read) {
-		throw std::exception("tape is not in read mode");
-	}
-	
-	last_record = current_record;
-
-	if (is_empty()) {
-		current_record = ArrayRecord::DNEArrayRecord();
-	}
-	else {
-		for (std::size_t i = 0; i < sizeof(current_record); ++i) {
-			reinterpret_cast<char*>(&current_record)[i] = getc();
+void FileTapeLibrary::BufferedTape::read_bytes(char* data, std::size_t size) {
+	// copy from buffer as much as it has, load next page when it is empty
+	while (size > 0) {
+		if (is_empty()) {
+			throw std::exception("tape is empty");
 		}
-				
-		// auto size = read_int();
-		// current_record = ArrayRecord(size);
-		//
-		// for (int i = 0; i < ArrayRecord::MAX_SIZE; ++i) {
-		// 	if (i < size) {
-		// 		current_record[i] = read_int();
-		// 	}
-		// 	else {
-		// 		read_int();
-		// 	}
-		// }
-	}
 
-	return current_record;
+		auto length = std::min(size, buffer_data_left);
+		std::memcpy(data, buffer.data() + buffer_next_index(), length);
+		buffer_data_left -= length;
+		data += length;
+		size -= length;
+	}
 }
 
-/*int FileTapeLibrary::Tape::read_int() {
+/*int FileTapeLibrary::BufferedTape::read_int() {
 	int i;
 	// read 4 bytes
 	for (std::size_t k = 0; k < sizeof(int); ++k) {
@@ -51,7 +44,7 @@ FileTapeLibrary::ArrayRecord FileTapeLibrary::Tape::read_next_record() {
 	return i;
 }*/
 
-char FileTapeLibrary::Tape::getc() {
+char FileTapeLibrary::BufferedTape::getc() {
 	// check if tape is empty and try to load more data to buffer
 	if (is_empty()) {
 		throw std::exception("tape is empty");
@@ -63,41 +56,34 @@ char FileTapeLibrary::Tape::getc() {
 	}*/
 	
 	// read byte from buffer
-	char c = buffer[buffer_next_index()];
+	char c = buffer.data()[buffer_next_index()];
 	// decrement buffer 
 	--buffer_data_left;
 	
 	return c;
 }
 
-void FileTapeLibrary::Tape::write_next_record(ArrayRecord record) {
+void FileTapeLibrary::BufferedTape::write_bytes(const char* data, std::size_t size) {
 	if (mode != write) {
 		throw std::exception("tape is not in write mode");
 	}
 
-	last_record = current_record;
-	current_record = record;
+	// copy to buffer as much as fits, empty full buffer to file
+	while (size > 0) {
+		if (buffer_data_left >= buffer_size) {
+			write_buffer();
+		}
 
-	char* data = reinterpret_cast<char*>(&record);
-	for (std::size_t i = 0; i < sizeof(record); ++i) {
-		putc(data[i]);
+		auto length = std::min(size, buffer_size - buffer_data_left);
+		std::memcpy(buffer.data() + buffer_data_left, data, length);
+		buffer_data_left += length;
+		data += length;
+		size -= length;
 	}
-	
-	/*// write size
-	write_int(record.size());
-	// write all data
-	for (std::size_t i = 0; i < ArrayRecord::MAX_SIZE; ++i) {
-		if (i < record.size()) {
-			write_int(record[i]);
-		}
-		else {
-			write_int(0);
-		}
-	}*/
 }
 /*
 
-void FileTapeLibrary::Tape::write_int(int i) {
+void FileTapeLibrary::BufferedTape::write_int(int i) {
 	// cast int to 4 bytes
 	const char* istr = reinterpret_cast<const char*>(&i);
 
@@ -109,26 +95,26 @@ void FileTapeLibrary::Tape::write_int(int i) {
 
 */
 
-void FileTapeLibrary::Tape::putc(char c) {
+void FileTapeLibrary::BufferedTape::putc(char c) {
 	if (mode != write) {
 		throw std::exception("tape is not in write mode");
 	}
 	
 	// if buffer is full
-	if (buffer_data_left >= BUFFER_SIZE) {					// should never be more than BUFFER_SIZE
+	if (buffer_data_left >= buffer_size) {					// should never be more than buffer_size
 		// empty buffer to file
 		write_buffer();
 	}
 
 	// write byte to the buffer
-	buffer[buffer_next_index()] = c;
+	buffer.data()[buffer_next_index()] = c;
 	
 	// increase valid buffer data size
 	++buffer_data_left;
 }
 
 
-void FileTapeLibrary::Tape::open(std::string filepath, open_mode mode) {
+void FileTapeLibrary::BufferedTape::open(std::string filepath, open_mode mode) {
 	this->filepath = filepath;
 	// end current mode
 	end_current_mode();
@@ -137,16 +123,12 @@ void FileTapeLibrary::Tape::open(std::string filepath, open_mode mode) {
 	init_mode(mode);
 }
 
-void FileTapeLibrary::Tape::close() {
+void FileTapeLibrary::BufferedTape::close() {
 	end_current_mode();
 	this->mode = none;
 }
 
-void FileTapeLibrary::Tape::end_current_mode() {
-	// no record has been read
-	last_record = ArrayRecord::DNEArrayRecord();
-	current_record = ArrayRecord::DNEArrayRecord();
-	
+void FileTapeLibrary::BufferedTape::end_current_mode() {
 	if (mode == read) {
 		// close input file
 		in.close();
@@ -165,17 +147,12 @@ void FileTapeLibrary::Tape::end_current_mode() {
 	this->mode = none;
 }
 
-void FileTapeLibrary::Tape::init_mode(open_mode mode) {
+void FileTapeLibrary::BufferedTape::init_mode(open_mode mode) {
 	this->mode = mode;
 	buffer_last_size = 0;
-
-	// no record has been read or written
-	last_record = ArrayRecord::DNEArrayRecord();
-	current_record = ArrayRecord::DNEArrayRecord();
 	
 	if (mode == read) {
 		// buffer is empty
-		record_read = false;
 		buffer_data_left = 0;
 		in.open(filepath, std::fstream::binary);
 	}
@@ -186,7 +163,7 @@ void FileTapeLibrary::Tape::init_mode(open_mode mode) {
 	}
 }
 
-bool FileTapeLibrary::Tape::is_empty() {
+bool FileTapeLibrary::BufferedTape::is_empty() {
 	if (mode != read) {
 		throw std::exception("tape is not in read mode");
 	}
@@ -210,53 +187,44 @@ bool FileTapeLibrary::Tape::is_empty() {
 	return false;
 }
 
-FileTapeLibrary::ArrayRecord FileTapeLibrary::Tape::get_current_record() {	
-	return current_record;
-}
-
-FileTapeLibrary::ArrayRecord FileTapeLibrary::Tape::get_last_record() {
-	return last_record;
-}
-
-void FileTapeLibrary::Tape::clear_last_record() {
-	last_record = ArrayRecord::DNEArrayRecord();
+unsigned long long FileTapeLibrary::BufferedTape::get_page_operations() const {
+	return page_operations;
 }
 
-bool FileTapeLibrary::Tape::is_progressing(bool progressing_policy(ArrayRecord ar1, ArrayRecord ar2)) const {
-	// if one or no record has been read - series is progressing
-	if (!last_record.is_valid()) {
-		return true;
+void FileTapeLibrary::BufferedTape::set_buffer_size(std::size_t size) {
+	if (size == 0) {
+		throw std::exception("Buffer size must be positive");
 	}
 
-	if (!current_record.is_valid()) {
-		return false;
-	}
-	
-	return progressing_policy(last_record, current_record);
+	buffer_size_setting = size;
 }
 
-unsigned long long FileTapeLibrary::Tape::get_page_operations() const {
-	return page_operations;
+std::size_t FileTapeLibrary::BufferedTape::get_buffer_size() {
+	return buffer_size_setting;
 }
 
-std::string FileTapeLibrary::Tape::get_filepath() const {
+std::string FileTapeLibrary::BufferedTape::get_filepath() const {
 	return filepath;
 }
 
+FileTapeLibrary::BufferedTape::open_mode FileTapeLibrary::BufferedTape::get_mode() const {
+	return mode;
+}
+
 // read portion of data to the buffer
-void FileTapeLibrary::Tape::read_buffer() {	
-	in.read(buffer, BUFFER_SIZE);
+void FileTapeLibrary::BufferedTape::read_buffer() {	
+	in.read(buffer.data(), buffer_size);
 	++page_operations;
 
 	if (!in.eof()) {
-		// all 'BUFFER_SIZE' bytes read successfully
-		//std::cout << "read " << BUFFER_SIZE << " bytes" << std::endl;
+		// all 'buffer_size' bytes read successfully
+		//std::cout << "read " << buffer_size << " bytes" << std::endl;
 		// buffer is full
-		buffer_data_left = BUFFER_SIZE;
+		buffer_data_left = buffer_size;
 	}
 	else {
 		//std::cout << "only " << in.gcount() << " could have been read" << std::endl;
-		// cast is safe since we already know BUFFER_SIZE > gcount()
+		// cast is safe since we already know buffer_size > gcount()
 		buffer_data_left = static_cast<std::size_t>(in.gcount());
 		// current buffer size is same as buffer_data_left
 		buffer_last_size = buffer_data_left;
@@ -264,21 +232,21 @@ void FileTapeLibrary::Tape::read_buffer() {
 	}
 }
 
-void FileTapeLibrary::Tape::write_buffer() {
-	out.write(buffer, buffer_data_left);
+void FileTapeLibrary::BufferedTape::write_buffer() {
+	out.write(buffer.data(), buffer_data_left);
 	++page_operations;
 	// buffer is now empty
 	buffer_data_left = 0;
 }
 
-std::size_t FileTapeLibrary::Tape::buffer_next_index() const {
+std::size_t FileTapeLibrary::BufferedTape::buffer_next_index() const {
 	// in read mode next index is position of first unread byte
 	if (mode == read) {
 		// last portion of data can be shorter than buffer
 		if (in.eof()) {
 			return buffer_last_size - buffer_data_left;
 		}
-		return BUFFER_SIZE - buffer_data_left;
+		return buffer_size - buffer_data_left;
 	}
 	// in write mode next index is place for next byte
 	if (mode == write) {
@@ -1,8 +1,21 @@
 #pragma once
+#include <fstream>
+#include <string>
+
 #include "ArrayRecord.h"
+#include "BufferPool.h"
 
 namespace FileTapeLibrary {
-	class Tape {
+	// tells tapes how to create DNE (empty, not existing) record of given type
+	template <typename Record>
+	struct record_traits {
+		static Record dne() {
+			return Record::DNEArrayRecord();
+		}
+	};
+
+	// file read or written sequentially through a buffer - tapes of all record types are built on it
+	class BufferedTape {
 	public:
 		// tape can be in two states
 		typedef int open_mode;
@@ -10,10 +23,14 @@ namespace FileTapeLibrary {
 		static constexpr open_mode read = 1 << 1;
 		static constexpr open_mode write = 1 << 2;
 
-		static constexpr std::size_t BUFFER_SIZE = 4096;
+		static constexpr std::size_t DEFAULT_BUFFER_SIZE = 4096;
+
+		// size of buffers of tapes created from now on - buffers are taken from BufferPool
+		static void set_buffer_size(std::size_t size);
+		static std::size_t get_buffer_size();
 
 		// default constructor 
-		Tape(std::string filepath, open_mode = none);
+		BufferedTape(std::string filepath, open_mode = none);
 		/*// copy constructor
 		Tape(const Tape& other);
 		// copy assignment
@@ -23,32 +40,27 @@ namespace FileTapeLibrary {
 		// move assignment
 		Tape& operator=(Tape&&);*/
 		//destructor
-		~Tape();
-
-		// read array record from tape
-		ArrayRecord read_next_record();
-
-		// write array record to tape
-		void write_next_record(ArrayRecord record);
+		~BufferedTape();
 
 		// set tape to work in read/write
 		void open(std::string filepath, open_mode mode);
 		void close();
 
-		ArrayRecord get_current_record();
-		ArrayRecord get_last_record();
-		// clear last record to assume series is progressing
-		void clear_last_record();
-		
 		/* for read mode only */
 		// check if end of tape has been exceeded
 		bool is_empty();
 
-		bool is_progressing(bool progressing_policy(ArrayRecord ar1, ArrayRecord ar2)) const;
-
 		unsigned long long get_page_operations() const;
 		std::string get_filepath() const;
-		
+
+	protected:
+		open_mode get_mode() const;
+
+		// read bytes from tape
+		void read_bytes(char* data, std::size_t size);
+		// write bytes to tape
+		void write_bytes(const char* data, std::size_t size);
+
 	private:
 		// read int from tape
 		//int read_int();
@@ -67,15 +79,13 @@ namespace FileTapeLibrary {
 		// write page to file
 		void write_buffer();
 
-		bool record_read = false;
-		ArrayRecord current_record;
-		ArrayRecord last_record;
 		open_mode mode;
 		std::string filepath;
 		std::ifstream in;
 		std::ofstream out;
 
-		char buffer[BUFFER_SIZE];
+		PooledBuffer buffer;
+		std::size_t buffer_size;
 
 		// how many valid bytes there are in buffer
 		// when in write mode this means that first {{buffer_data_left}} bytes were written
@@ -89,4 +99,133 @@ namespace FileTapeLibrary {
 		// counter of buffer's outputs or inputs
 		unsigned long long page_operations;
 	};
+
+	// tape of records - records are stored as raw bytes, one after another
+	template <typename Record>
+	class BasicTape : public BufferedTape {
+	public:
+		BasicTape(std::string filepath, open_mode mode = none);
+
+		// read record from tape
+		const Record& read_next_record();
+
+		// write record to tape
+		void write_next_record(const Record& record);
+		// write count records at once - they are copied to buffer in blocks
+		void write_records(const Record* records, std::size_t count);
+
+		// set tape to work in read/write
+		void open(std::string filepath, open_mode mode);
+		void close();
+
+		const Record& get_current_record() const;
+		const Record& get_last_record() const;
+		// clear last record to assume series is progressing
+		void clear_last_record();
+
+		// progressing_policy(last_record, current_record) tells if records are in order
+		template <typename Comparator>
+		bool is_progressing(const Comparator& progressing_policy) const;
+
+	private:
+		Record current_record = record_traits<Record>::dne();
+		Record last_record = record_traits<Record>::dne();
+	};
+
+	typedef BasicTape<ArrayRecord> Tape;
+
+	template <typename Record>
+	BasicTape<Record>::BasicTape(std::string filepath, open_mode mode) : BufferedTape(filepath, mode) {}
+
+	template <typename Record>
+	const Record& BasicTape<Record>::read_next_record() {
+		if (get_mode() != read) {
+			throw std::exception("tape is not in read mode");
+		}
+
+		last_record = current_record;
+
+		if (is_empty()) {
+			current_record = record_traits<Record>::dne();
+		}
+		else {
+			read_bytes(reinterpret_cast<char*>(&current_record), sizeof(current_record));
+		}
+
+		return current_record;
+	}
+
+	template <typename Record>
+	void BasicTape<Record>::write_next_record(const Record& record) {
+		if (get_mode() != write) {
+			throw std::exception("tape is not in write mode");
+		}
+
+		last_record = current_record;
+		current_record = record;
+
+		write_bytes(reinterpret_cast<const char*>(&record), sizeof(record));
+	}
+
+	template <typename Record>
+	void BasicTape<Record>::write_records(const Record* records, std::size_t count) {
+		if (get_mode() != write) {
+			throw std::exception("tape is not in write mode");
+		}
+		if (count == 0) {
+			return;
+		}
+
+		write_bytes(reinterpret_cast<const char*>(records), count * sizeof(Record));
+
+		last_record = count > 1 ? records[count - 2] : current_record;
+		current_record = records[count - 1];
+	}
+
+	template <typename Record>
+	void BasicTape<Record>::open(std::string filepath, open_mode mode) {
+		BufferedTape::open(filepath, mode);
+
+		// no record has been read or written
+		last_record = record_traits<Record>::dne();
+		current_record = record_traits<Record>::dne();
+	}
+
+	template <typename Record>
+	void BasicTape<Record>::close() {
+		BufferedTape::close();
+
+		last_record = record_traits<Record>::dne();
+		current_record = record_traits<Record>::dne();
+	}
+
+	template <typename Record>
+	const Record& BasicTape<Record>::get_current_record() const {
+		return current_record;
+	}
+
+	template <typename Record>
+	const Record& BasicTape<Record>::get_last_record() const {
+		return last_record;
+	}
+
+	template <typename Record>
+	void BasicTape<Record>::clear_last_record() {
+		last_record = record_traits<Record>::dne();
+	}
+
+	template <typename Record>
+	template <typename Comparator>
+	bool BasicTape<Record>::is_progressing(const Comparator& progressing_policy) const {
+		// if one or no record has been read - series is progressing
+		if (!last_record.is_valid()) {
+			return true;
+		}
+
+		if (!current_record.is_valid()) {
+			return false;
+		}
+
+		return progressing_policy(last_record, current_record);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <charconv>
+
+#include "TextFormat.h"
+
+namespace {
+	bool is_separator(char c) {
+		// '{' begins a record - like whitespace, it doesn't carry data
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f' || c == '{';
+	}
+
+	const char* skip_separators(const char* begin, const char* end) {
+		while (begin != end && is_separator(*begin)) {
+			++begin;
+		}
+		return begin;
+	}
+}
+
+const char* FileTapeLibrary::text::parse_user_format_values(const char* begin, const char* end, int* values, std::size_t capacity, std::size_t& size) {
+	size = 0;
+
+	// record is complete only if it ends with '}'
+	auto record_end = begin;
+	while (record_end != end && *record_end != '}') {
+		++record_end;
+	}
+	if (record_end == end) {
+		return nullptr;
+	}
+
+	auto position = skip_separators(begin, record_end);
+
+	while (true) {
+		// from_chars doesn't accept '+' sign
+		if (position != record_end && *position == '+') {
+			++position;
+		}
+
+		auto value = 0;
+		auto [next, error] = std::from_chars(position, record_end, value);
+		if (error != std::errc()) {
+			throw std::exception("Wrong input");
+		}
+		if (size == capacity) {
+			throw std::exception("record is too long");
+		}
+		values[size++] = value;
+
+		position = skip_separators(next, record_end);
+		if (position == record_end) {
+			return record_end + 1;
+		}
+		if (*position != ',') {
+			throw std::exception("Wrong input");
+		}
+		position = skip_separators(position + 1, record_end);
+	}
+}
+
+char* FileTapeLibrary::text::format_values(const int* values, std::size_t size, format text_format, char* out) {
+	auto separator = text_format == format::csv ? "," : ", ";
+	auto separator_length = text_format == format::csv ? std::size_t(1) : std::size_t(2);
+
+	if (text_format == format::braces) {
+		*out++ = '{';
+		*out++ = ' ';
+	}
+
+	for (std::size_t i = 0; i < size; ++i) {
+		if (i > 0) {
+			out = std::copy(separator, separator + separator_length, out);
+		}
+		// 11 characters are enough for any int
+		out = std::to_chars(out, out + 11, values[i]).ptr;
+	}
+
+	if (text_format == format::braces) {
+		*out++ = ' ';
+		*out++ = '}';
+	}
+	*out++ = '\n';
+
+	return out;
+}
+
+std::size_t FileTapeLibrary::text::find_records_end(const char* data, std::size_t size) {
+	while (size > 0 && data[size - 1] != '}') {
+		--size;
+	}
+	return size;
+}
+
+std::vector<std::size_t> FileTapeLibrary::text::split_records(const char* data, std::size_t size, std::size_t parts_count) {
+	auto bounds = std::vector<std::size_t>{ 0 };
+	auto part_size = (size + parts_count - 1) / parts_count;
+
+	while (bounds.back() < size) {
+		// part ends at first '}' after its expected length
+		auto bound = std::min(bounds.back() + part_size, size);
+		while (data[bound - 1] != '}') {
+			++bound;
+		}
+		bounds.push_back(bound);
+	}
+
+	return bounds;
+}
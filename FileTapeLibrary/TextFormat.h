@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace FileTapeLibrary {
+	namespace text {
+		// formats of records written as text
+		// - braces: user format, "{ 1, -2, 3 }" (as operator<< of records)
+		// - csv: "1,-2,3"
+		enum class format { braces, csv };
+
+		// how many records are formatted at once - block is split between formatting threads
+		constexpr std::size_t EXPORT_BLOCK_LENGTH = std::size_t(1) << 16;
+
+		// upper bound of text length of record with size values (line end included)
+		constexpr std::size_t get_max_record_length(std::size_t size) {
+			// "{ " + values with ", " (int has at most 11 characters) + " }" + '\n'
+			return 4 + size * 13 + 1;
+		}
+
+		// writes record with line end to out, which has place for get_max_record_length(size) characters
+		// returns end of written text
+		char* format_values(const int* values, std::size_t size, format text_format, char* out);
+
+		/*
+		 * parsing of user format - records are written as "{ 1, -2, 3 }", with any whitespace between tokens
+		 * text is parsed in place with std::from_chars, without allocations
+		 */
+
+		// how much of user format file is read at once - block is split between parsing threads
+		constexpr std::size_t IMPORT_BLOCK_SIZE = std::size_t(1) << 24;
+
+		// parses first record of [begin, end) to values (which have place for capacity values)
+		// returns pointer past the '}' which ends the record, nullptr if there is no more records
+		// (only whitespace or an unfinished record is left); wrong record throws
+		const char* parse_user_format_values(const char* begin, const char* end, int* values, std::size_t capacity, std::size_t& size);
+
+		// length of [data, data + size) up to the last '}' (included) - text of complete records, 0 if there is none
+		std::size_t find_records_end(const char* data, std::size_t size);
+
+		// splits text of complete records to at most parts_count parts of similar lengths, which end with '}'
+		// returns offsets of part bounds: 0, ..., size
+		std::vector<std::size_t> split_records(const char* data, std::size_t size, std::size_t parts_count);
+	}
+}
@@ -1,135 +1,188 @@
 #include "TreePage.h"
 
-#include <iostream>
+#include <algorithm>
 
-FileTapeLibrary::TreePage::TreePage(offset_t self_offset) {
-	this->self_offset = self_offset;
-	parent_offset = NIL_OFFSET;
-	std::fill(keys.begin(), keys.end(), NIL_INDEX);
-	std::fill(record_offsets.begin(), record_offsets.end(), NIL_OFFSET);
-	std::fill(children.begin(), children.end(), NIL_OFFSET);
+std::size_t FileTapeLibrary::TreePage::get_order(std::size_t size) {
+	if (size % sizeof(std::uint64_t) != 0) {
+		throw std::exception("Size of page must be a multiple of 8");
+	}
+
+	// header, 2d keys, 2d record offsets and 2d + 1 children
+	auto entries_size = size < sizeof(Header) + sizeof(offset_t) ? 0 : size - sizeof(Header) - sizeof(offset_t);
+	auto order = entries_size / (2 * (sizeof(index_t) + 2 * sizeof(offset_t)));
+	if (order < 2) {
+		throw std::exception("Page is too small");
+	}
+
+	return order;
+}
+
+FileTapeLibrary::TreePage::TreePage(offset_t self_offset, std::size_t size) : order(get_order(size)), image(size / sizeof(std::uint64_t)) {
+	header().magic = MAGIC;
+	header().version = VERSION;
+	header().order = static_cast<std::uint32_t>(order);
+	header().keys_count = 0;
+	header().self_offset = self_offset;
+	header().parent_offset = NIL_OFFSET;
+
+	std::fill(keys(), keys() + 2 * order, NIL_INDEX);
+	std::fill(record_offsets(), record_offsets() + 2 * order, NIL_OFFSET);
+	std::fill(children(), children() + 2 * order + 1, NIL_OFFSET);
 }
 
 std::size_t FileTapeLibrary::TreePage::find_position_for_key(index_t key) {
-	for (std::size_t i = 0; i < keys.size() - 1; ++i) {
-		// If keys[i] is place for key (or if is empty)
-		if (key <= keys[i] || keys[i] == NIL_INDEX) {
-			return i;
-		}
+	auto count = get_keys_count();
+	if (count == 0) {
+		return 0;
 	}
 
-	return keys.size();
+	// branchless binary search - halves are chosen with conditional moves, not jumps
+	auto base = keys();
+	while (count > 1) {
+		auto half = count / 2;
+		base = base[half] < key ? base + half : base;
+		count -= half;
+	}
+
+	return static_cast<std::size_t>(base - keys()) + (*base < key ? 1 : 0);
 }
 
 FileTapeLibrary::offset_t FileTapeLibrary::TreePage::get_left_child_offset(std::size_t position) {
-	return children[position];
+	return children()[position];
 }
 
 void FileTapeLibrary::TreePage::set_left_child_offset(std::size_t position, offset_t offset) {
-	children[position] = offset;
+	children()[position] = offset;
 }
 
 FileTapeLibrary::offset_t FileTapeLibrary::TreePage::get_right_child_offset(std::size_t position) {
-	return children[position + 1];
+	return children()[position + 1];
 }
 
 void FileTapeLibrary::TreePage::set_right_child_offset(std::size_t position, offset_t offset) {
-	children[position] = offset;
+	children()[position + 1] = offset;
 }
 
 bool FileTapeLibrary::TreePage::is_root() {
-	return parent_offset == NIL_OFFSET;
+	return header().parent_offset == NIL_OFFSET;
+}
+
+bool FileTapeLibrary::TreePage::is_leaf() {
+	return children()[0] == NIL_OFFSET;
+}
+
+bool FileTapeLibrary::TreePage::is_full() {
+	return get_keys_count() == get_capacity();
+}
+
+std::size_t FileTapeLibrary::TreePage::get_keys_count() {
+	return header().keys_count;
+}
+
+std::size_t FileTapeLibrary::TreePage::get_capacity() {
+	return 2 * order;
+}
+
+std::size_t FileTapeLibrary::TreePage::get_size() {
+	return image.size() * sizeof(std::uint64_t);
+}
+
+FileTapeLibrary::offset_t FileTapeLibrary::TreePage::get_self_offset() {
+	return header().self_offset;
+}
+
+FileTapeLibrary::offset_t FileTapeLibrary::TreePage::get_parent_offset() {
+	return header().parent_offset;
+}
+
+void FileTapeLibrary::TreePage::set_parent_offset(offset_t offset) {
+	header().parent_offset = offset;
 }
 
 FileTapeLibrary::index_t FileTapeLibrary::TreePage::get_key(std::size_t position) {
-	return keys[position];
+	return keys()[position];
 }
 
 void FileTapeLibrary::TreePage::set_key(std::size_t position, index_t key) {
-	keys[position] = key;
+	keys()[position] = key;
 }
 
 FileTapeLibrary::offset_t FileTapeLibrary::TreePage::get_record_offset(std::size_t position) {
-	return record_offsets[position];
+	return record_offsets()[position];
 }
 
 void FileTapeLibrary::TreePage::set_record_offset(std::size_t position, offset_t key) {
-	record_offsets[position] = key;
+	record_offsets()[position] = key;
 }
 
 bool FileTapeLibrary::TreePage::is_empty_key(std::size_t position) {
-	return keys[position] == NIL_INDEX;
-}
-
-/*
-void FileTapeLibrary::TreePage::read_from_file(offset_t offset, std::string& filepath) {
-	self_offset = offset;
-	
-	auto file = std::ifstream(filepath, std::ios::binary | std::ios::out | std::ios::in);
-	file.seekg(offset);
-	file.read(
-		reinterpret_cast<char*>(&parent_offset),
-		sizeof(parent_offset)
-	);
-	file.read(
-		reinterpret_cast<char*>(keys.data()),
-		static_cast<unsigned long long>(sizeof(index_t)) * keys.size()
-	);
-	file.read(
-		reinterpret_cast<char*>(record_offsets.data()),
-		static_cast <unsigned long long>(sizeof(offset_t)) * keys.size()
-	);
-	file.read(
-		reinterpret_cast<char*>(children.data()),
-		static_cast <unsigned long long>(sizeof(offset_t)) * children.size()
-	);
-}*/
-
-void FileTapeLibrary::TreePage::read_from_file(std::string& filepath) {
-	auto file = std::ifstream(filepath, std::ios::binary | std::ios::out | std::ios::in);
-	file.seekg(self_offset);
-	file.read(
-		reinterpret_cast<char*>(&parent_offset),
-		sizeof(parent_offset)
-	);
-	file.read(
-		reinterpret_cast<char*>(keys.data()),
-		static_cast<unsigned long long>(sizeof(index_t)) * keys.size()
-	);
-	file.read(
-		reinterpret_cast<char*>(record_offsets.data()),
-		static_cast <unsigned long long>(sizeof(offset_t)) * keys.size()
-	);
-	file.read(
-		reinterpret_cast<char*>(children.data()),
-		static_cast <unsigned long long>(sizeof(offset_t)) * children.size()
-	);
-}
-
-void FileTapeLibrary::TreePage::write_to_file(std::string& filepath) {
-	auto file = std::ofstream(filepath, std::ios::binary | std::ios::out | std::ios::in);
-	
-	file.seekp(self_offset);
-	file.write(
-		reinterpret_cast<const char*>(&parent_offset), 
-		sizeof(parent_offset)
-	);
-	file.write(
-		reinterpret_cast<const char*>(keys.data()),
-		static_cast<unsigned long long>(sizeof(index_t)) * keys.size()
-	);
-	file.write(
-		reinterpret_cast<const char*>(record_offsets.data()),
-		static_cast <unsigned long long>(sizeof(offset_t)) * keys.size()
-	);
-	file.write(
-		reinterpret_cast<const char*>(children.data()),
-		static_cast <unsigned long long>(sizeof(offset_t)) * children.size()
-	);
-}
-
-/*
-FileTapeLibrary::index_t& FileTapeLibrary::TreePage::operator[](std::size_t i) {
-	return keys[i];
-}
-*/
+	return position >= get_keys_count();
+}
+
+void FileTapeLibrary::TreePage::insert_key(std::size_t position, index_t key, offset_t record_offset, offset_t right_child) {
+	auto count = get_keys_count();
+
+	std::copy_backward(keys() + position, keys() + count, keys() + count + 1);
+	std::copy_backward(record_offsets() + position, record_offsets() + count, record_offsets() + count + 1);
+	std::copy_backward(children() + position + 1, children() + count + 1, children() + count + 2);
+
+	keys()[position] = key;
+	record_offsets()[position] = record_offset;
+	children()[position + 1] = right_child;
+	++header().keys_count;
+}
+
+void FileTapeLibrary::TreePage::get_entries(std::vector<index_t>& keys, std::vector<offset_t>& record_offsets, std::vector<offset_t>& children) {
+	auto count = get_keys_count();
+
+	keys.insert(keys.end(), this->keys(), this->keys() + count);
+	record_offsets.insert(record_offsets.end(), this->record_offsets(), this->record_offsets() + count);
+	children.insert(children.end(), this->children(), this->children() + count + 1);
+}
+
+void FileTapeLibrary::TreePage::set_entries(
+	const std::vector<index_t>& keys,
+	const std::vector<offset_t>& record_offsets,
+	const std::vector<offset_t>& children,
+	std::size_t first,
+	std::size_t last
+) {
+	std::fill(this->keys(), this->keys() + 2 * order, NIL_INDEX);
+	std::fill(this->record_offsets(), this->record_offsets() + 2 * order, NIL_OFFSET);
+	std::fill(this->children(), this->children() + 2 * order + 1, NIL_OFFSET);
+
+	std::copy(keys.begin() + first, keys.begin() + last, this->keys());
+	std::copy(record_offsets.begin() + first, record_offsets.begin() + last, this->record_offsets());
+	std::copy(children.begin() + first, children.begin() + last + 1, this->children());
+	header().keys_count = static_cast<std::uint32_t>(last - first);
+}
+
+void FileTapeLibrary::TreePage::read_from_file(RandomAccessFile& file) {
+	auto self_offset = get_self_offset();
+	auto size = get_size();
+
+	auto read = file.read_at(self_offset, reinterpret_cast<char*>(image.data()), size);
+	if (read != size || header().magic != MAGIC || header().version != VERSION || header().order != order || header().self_offset != self_offset) {
+		throw std::exception("Wrong page in index file");
+	}
+}
+
+void FileTapeLibrary::TreePage::write_to_file(RandomAccessFile& file) {
+	file.write_at(get_self_offset(), reinterpret_cast<const char*>(image.data()), get_size());
+}
+
+FileTapeLibrary::TreePage::Header& FileTapeLibrary::TreePage::header() {
+	return *reinterpret_cast<Header*>(image.data());
+}
+
+FileTapeLibrary::index_t* FileTapeLibrary::TreePage::keys() {
+	return reinterpret_cast<index_t*>(image.data() + sizeof(Header) / sizeof(std::uint64_t));
+}
+
+FileTapeLibrary::offset_t* FileTapeLibrary::TreePage::record_offsets() {
+	return reinterpret_cast<offset_t*>(keys() + 2 * order);
+}
+
+FileTapeLibrary::offset_t* FileTapeLibrary::TreePage::children() {
+	return reinterpret_cast<offset_t*>(record_offsets() + 2 * order);
+}
@@ -1,17 +1,41 @@
 #pragma once
-#include <array>
-#include <fstream>
+#include <cstdint>
 #include <limits>
+#include <vector>
 
 #include "typedefs.h"
+#include "BufferPool.h"
+#include "RandomAccessFile.h"
 
 namespace FileTapeLibrary {
+	/*
+	 * page of BTree index - object holds exact image of the page in file:
+	 * header, 2d keys, 2d record offsets, 2d + 1 children
+	 * d (order) follows from size of the page, so pages fill whole blocks of the device
+	 */
 	class TreePage {
 	public:
-		static constexpr std::size_t D = 4;
-		static constexpr std::size_t SIZE_IN_FILE = sizeof(offset_t) + 2 * D * sizeof(index_t) + 2 * D * sizeof(offset_t) + (2 * D + 1) * sizeof(offset_t);
-		TreePage(offset_t self_offset);
+		static constexpr std::size_t DEFAULT_SIZE = 4096;
+		// "BTPG"
+		static constexpr std::uint32_t MAGIC = 0x47505442;
+		static constexpr std::uint32_t VERSION = 1;
 
+		struct Header {
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint32_t order;
+			std::uint32_t keys_count;
+			offset_t self_offset;
+			// if parent_offset is set to max offset_t value - that means current page is root
+			offset_t parent_offset;
+		};
+
+		// d of pages of given size - throws if page is too small or its size is not a multiple of 8
+		static std::size_t get_order(std::size_t size);
+
+		TreePage(offset_t self_offset, std::size_t size = DEFAULT_SIZE);
+
+		// position of first key not smaller than given key (number of keys if all are smaller)
 		std::size_t find_position_for_key(index_t key);
 		offset_t get_left_child_offset(std::size_t position);
 		void set_left_child_offset(std::size_t position, offset_t offset);
@@ -19,8 +43,16 @@ namespace FileTapeLibrary {
 		void set_right_child_offset(std::size_t position, offset_t offset);
 
 		bool is_root();
+		bool is_leaf();
+		bool is_full();
+		std::size_t get_keys_count();
+		// 2d
+		std::size_t get_capacity();
+		std::size_t get_size();
 
-		//index_t& operator[](std::size_t i);
+		offset_t get_self_offset();
+		offset_t get_parent_offset();
+		void set_parent_offset(offset_t offset);
 
 		index_t get_key(std::size_t position);
 		void set_key(std::size_t position, index_t key);
@@ -30,16 +62,32 @@ namespace FileTapeLibrary {
 
 		bool is_empty_key(std::size_t position);
 
-		//void read_from_file(offset_t offset, std::string& filepath);
-		void read_from_file(std::string& filepath);
-		void write_to_file(std::string& filepaths);
+		// page must not be full - keys from position on are moved right, right_child becomes right child of key
+		void insert_key(std::size_t position, index_t key, offset_t record_offset, offset_t right_child);
+
+		// appends keys, their record offsets and children (one more than keys) to the vectors
+		void get_entries(std::vector<index_t>& keys, std::vector<offset_t>& record_offsets, std::vector<offset_t>& children);
+		// replaces content of page with keys [first, last) and children [first, last] of the vectors
+		void set_entries(
+			const std::vector<index_t>& keys,
+			const std::vector<offset_t>& record_offsets,
+			const std::vector<offset_t>& children,
+			std::size_t first,
+			std::size_t last
+		);
+
+		// page is read and written with one positional call at self_offset
+		// reading throws if there is no valid page of the same size
+		void read_from_file(RandomAccessFile& file);
+		void write_to_file(RandomAccessFile& file);
 	private:
+		Header& header();
+		index_t* keys();
+		offset_t* record_offsets();
+		offset_t* children();
 
-		offset_t self_offset;
-		// if parent_offset is set to max offset_t value - that means current page is root
-		offset_t parent_offset;
-		std::array<index_t, 2 * D> keys;
-		std::array<offset_t, 2 * D> record_offsets;
-		std::array<offset_t, 2 * D + 1> children;
+		std::size_t order;
+		// 8-byte words keep keys and offsets aligned
+		pooled_vector<std::uint64_t> image;
 	};
 }
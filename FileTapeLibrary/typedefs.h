@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include <limits>
 
 namespace FileTapeLibrary {
 	typedef unsigned long long index_t;
@@ -0,0 +1,33 @@
+#include <filesystem>
+#include <iostream>
+#include <tuple>
+
+#include <FileTapeLibrary.h>
+
+// worker of sharded sort (see ShardedSort.h) - sorts one shard with polyphase merge sort
+// usage: "Shard worker" <input tape> <output tape> <scratch directory>
+int main(int argc, char** argv) {
+	if (argc != 4) {
+		std::cerr << "usage: " << argv[0] << " <input tape> <output tape> <scratch directory>" << std::endl;
+		return 2;
+	}
+
+	auto input_path = std::string(argv[1]);
+	auto output_path = std::string(argv[2]);
+	auto scratch_directory = std::string(argv[3]);
+
+	try {
+		std::filesystem::create_directories(scratch_directory);
+
+		auto sort_policy = FileTapeLibrary::KeySortingPolicy<FileTapeLibrary::MaxKey>();
+		auto [phases, page_operations] = FileTapeLibrary::polyphase_merge_sort(input_path, output_path, sort_policy, scratch_directory);
+
+		std::cout << input_path << ": sorted after " << phases << " phases, " << page_operations << " disc operations" << std::endl;
+	}
+	catch (std::exception& e) {
+		std::cerr << input_path << ": " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
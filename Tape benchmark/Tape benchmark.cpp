@@ -0,0 +1,328 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <FileTapeLibrary.h>
+
+// raw read(2) / write(2) of the same files - reference speed of the device
+namespace raw {
+#if defined(_WIN32)
+	int open_read(const std::string& path) { return _open(path.c_str(), _O_RDONLY | _O_BINARY); }
+	int open_write(const std::string& path) { return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644); }
+	long long read(int file, char* data, std::size_t size) { return _read(file, data, static_cast<unsigned int>(size)); }
+	long long write(int file, const char* data, std::size_t size) { return _write(file, data, static_cast<unsigned int>(size)); }
+	void close(int file) { _close(file); }
+#else
+	int open_read(const std::string& path) { return ::open(path.c_str(), O_RDONLY); }
+	int open_write(const std::string& path) { return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644); }
+	long long read(int file, char* data, std::size_t size) { return ::read(file, data, size); }
+	long long write(int file, const char* data, std::size_t size) { return ::write(file, data, size); }
+	void close(int file) { ::close(file); }
+#endif
+}
+
+struct BenchmarkOptions {
+	// size of every tape
+	unsigned long long bytes = 1ull << 26;
+	std::vector<std::size_t> buffer_sizes = { 4096, 65536, 1 << 20 };
+	// widths of records - 4, 15 or 64 values
+	std::vector<std::size_t> record_widths = { 4, 15, 64 };
+	unsigned long long open_close_cycles = 10000;
+	// best of repetitions is taken - it is the least disturbed by the rest of the system
+	std::size_t repetitions = 3;
+	std::string directory = "./data";
+	std::string save_baseline_path;
+	std::string baseline_path;
+	// allowed drop of throughput against baseline, in %
+	double threshold = 10.0;
+};
+
+template <typename Function>
+double measure_seconds(Function function) {
+	auto start = std::chrono::steady_clock::now();
+	function();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// throughputs (MB/s or cycles/s) by name of benchmark
+typedef std::map<std::string, double> Results;
+
+void add_result(Results& results, const std::string& name, double throughput, const char* unit) {
+	auto& best = results[name];
+	best = std::max(best, throughput);
+	std::cout << name << ": " << throughput << " " << unit << std::endl;
+}
+
+void benchmark_raw(Results& results, const BenchmarkOptions& options, std::size_t buffer_size) {
+	auto path = options.directory + "/tape_benchmark_raw.dat";
+	auto buffer = std::vector<char>(buffer_size, 1);
+	auto name = "raw/" + std::to_string(buffer_size);
+	auto megabytes = options.bytes / 1e6;
+
+	auto write_seconds = measure_seconds([&]() {
+		auto file = raw::open_write(path);
+		if (file < 0) {
+			throw std::exception("Could not open file");
+		}
+		for (auto written = 0ull; written < options.bytes; written += buffer_size) {
+			auto size = static_cast<std::size_t>(std::min<unsigned long long>(buffer_size, options.bytes - written));
+			if (raw::write(file, buffer.data(), size) != static_cast<long long>(size)) {
+				throw std::exception("Could not write file");
+			}
+		}
+		raw::close(file);
+	});
+	add_result(results, name + "/write", megabytes / write_seconds, "MB/s");
+
+	auto read_seconds = measure_seconds([&]() {
+		auto file = raw::open_read(path);
+		if (file < 0) {
+			throw std::exception("Could not open file");
+		}
+		while (raw::read(file, buffer.data(), buffer_size) > 0) {}
+		raw::close(file);
+	});
+	add_result(results, name + "/read", megabytes / read_seconds, "MB/s");
+
+	std::filesystem::remove(path);
+}
+
+template <typename Record>
+void benchmark_records(Results& results, const BenchmarkOptions& options, std::size_t buffer_size) {
+	auto path = options.directory + "/tape_benchmark.dat";
+	auto copy_path = options.directory + "/tape_benchmark_copy.dat";
+	auto records_count = std::max(1ull, options.bytes / sizeof(Record));
+	auto megabytes = records_count * sizeof(Record) / 1e6;
+	auto name = "tape/" + std::to_string(buffer_size) + "/" + std::to_string(Record::MAX_SIZE);
+
+	auto record = Record();
+	for (std::size_t i = 0; i < record.size(); ++i) {
+		record[i] = static_cast<int>(i);
+	}
+
+	auto write_seconds = measure_seconds([&]() {
+		auto tape = FileTapeLibrary::BasicTape<Record>(path, FileTapeLibrary::BufferedTape::write);
+		for (auto i = 0ull; i < records_count; ++i) {
+			tape.write_next_record(record);
+		}
+	});
+	add_result(results, name + "/write", megabytes / write_seconds, "MB/s");
+
+	// sum of values keeps reading from being optimized out
+	auto sum = 0ll;
+	auto read_seconds = measure_seconds([&]() {
+		auto tape = FileTapeLibrary::BasicTape<Record>(path, FileTapeLibrary::BufferedTape::read);
+		while (!tape.is_empty()) {
+			sum += tape.read_next_record()[0];
+		}
+	});
+	add_result(results, name + "/read", megabytes / read_seconds, "MB/s");
+
+	auto copy_seconds = measure_seconds([&]() {
+		FileTapeLibrary::copy_file<Record>(path, copy_path);
+	});
+	add_result(results, name + "/copy", megabytes / copy_seconds, "MB/s");
+
+	if (sum == -1) {
+		std::cout << sum << std::endl;
+	}
+
+	std::filesystem::remove(path);
+	std::filesystem::remove(copy_path);
+}
+
+void benchmark_open_close(Results& results, const BenchmarkOptions& options, std::size_t buffer_size) {
+	auto path = options.directory + "/tape_benchmark_open.dat";
+	FileTapeLibrary::initialize_random_tape(path, 1);
+
+	// one record is read in every cycle, so buffer is filled as well
+	auto tape = FileTapeLibrary::Tape(path);
+	auto seconds = measure_seconds([&]() {
+		for (auto i = 0ull; i < options.open_close_cycles; ++i) {
+			tape.open(path, FileTapeLibrary::BufferedTape::read);
+			tape.read_next_record();
+			tape.close();
+		}
+	});
+	add_result(results, "tape/" + std::to_string(buffer_size) + "/open_close", options.open_close_cycles / seconds, "cycles/s");
+
+	std::filesystem::remove(path);
+}
+
+Results run_benchmarks(const BenchmarkOptions& options) {
+	std::filesystem::create_directories(options.directory);
+	auto results = Results();
+
+	for (std::size_t repetition = 0; repetition < options.repetitions; ++repetition) {
+		for (auto buffer_size : options.buffer_sizes) {
+			FileTapeLibrary::BufferedTape::set_buffer_size(buffer_size);
+
+			benchmark_raw(results, options, buffer_size);
+			for (auto width : options.record_widths) {
+				switch (width) {
+				case 4:
+					benchmark_records<FileTapeLibrary::BasicArrayRecord<4>>(results, options, buffer_size);
+					break;
+				case 15:
+					benchmark_records<FileTapeLibrary::BasicArrayRecord<15>>(results, options, buffer_size);
+					break;
+				case 64:
+					benchmark_records<FileTapeLibrary::BasicArrayRecord<64>>(results, options, buffer_size);
+					break;
+				default:
+					throw std::exception("Record width must be 4, 15 or 64");
+				}
+			}
+			benchmark_open_close(results, options, buffer_size);
+		}
+	}
+
+	FileTapeLibrary::BufferedTape::set_buffer_size(FileTapeLibrary::BufferedTape::DEFAULT_BUFFER_SIZE);
+	return results;
+}
+
+// baseline file has one "name throughput" pair in every line
+void save_results(const std::string& path, const Results& results) {
+	auto file = std::ofstream(path, std::ios_base::binary);
+	for (const auto& [name, throughput] : results) {
+		file << name << ' ' << throughput << '\n';
+	}
+}
+
+Results load_results(const std::string& path) {
+	auto file = std::ifstream(path, std::ios_base::binary);
+	if (!file) {
+		throw std::exception("Could not open baseline");
+	}
+
+	auto results = Results();
+	auto name = std::string();
+	auto throughput = 0.0;
+	while (file >> name >> throughput) {
+		results[name] = throughput;
+	}
+
+	return results;
+}
+
+// returns number of benchmarks which are slower than baseline by more than threshold %
+std::size_t compare_results(const Results& results, const Results& baseline, double threshold) {
+	auto regressions = std::size_t(0);
+
+	for (const auto& [name, baseline_throughput] : baseline) {
+		auto result = results.find(name);
+		if (result == results.end()) {
+			continue;
+		}
+
+		auto change = (result->second - baseline_throughput) / baseline_throughput * 100.0;
+		auto regression = change < -threshold;
+		regressions += regression ? 1 : 0;
+
+		std::cout << (regression ? "REGRESSION " : "ok         ") << name << ": " << result->second
+			<< " (baseline " << baseline_throughput << ", " << change << "%)" << std::endl;
+	}
+
+	return regressions;
+}
+
+std::vector<std::size_t> parse_sizes(const std::string& text) {
+	auto sizes = std::vector<std::size_t>();
+	auto stream = std::istringstream(text);
+	auto part = std::string();
+
+	while (std::getline(stream, part, ',')) {
+		if (!part.empty()) {
+			sizes.push_back(std::stoull(part));
+		}
+	}
+
+	return sizes;
+}
+
+// usage: Tape benchmark [options]
+//          --bytes 67108864               size of every tape
+//          --buffer-sizes 4096,65536      sizes of tape buffers (raw reads and writes use the same sizes)
+//          --record-widths 4,15,64        values in records
+//          --cycles 10000                 open/close cycles
+//          --repetitions 3                best of repetitions is reported
+//          --directory ./data             directory of benchmark files
+//          --save-baseline baseline.txt   stores throughputs
+//          --baseline baseline.txt        compares throughputs with stored ones - fails if any of them
+//          --threshold 10                 is lower by more than threshold %
+int main(int argc, char** argv) {
+	auto options = BenchmarkOptions();
+
+	try {
+		for (int i = 1; i + 1 < argc; i += 2) {
+			auto name = std::string(argv[i]);
+			auto value = std::string(argv[i + 1]);
+
+			if (name == "--bytes") {
+				options.bytes = static_cast<unsigned long long>(std::stod(value));
+			}
+			else if (name == "--buffer-sizes") {
+				options.buffer_sizes = parse_sizes(value);
+			}
+			else if (name == "--record-widths") {
+				options.record_widths = parse_sizes(value);
+			}
+			else if (name == "--cycles") {
+				options.open_close_cycles = std::stoull(value);
+			}
+			else if (name == "--repetitions") {
+				options.repetitions = std::max(1ull, std::stoull(value));
+			}
+			else if (name == "--directory") {
+				options.directory = value;
+			}
+			else if (name == "--save-baseline") {
+				options.save_baseline_path = value;
+			}
+			else if (name == "--baseline") {
+				options.baseline_path = value;
+			}
+			else if (name == "--threshold") {
+				options.threshold = std::stod(value);
+			}
+			else {
+				throw std::exception("Unknown option");
+			}
+		}
+
+		auto results = run_benchmarks(options);
+
+		if (!options.save_baseline_path.empty()) {
+			save_results(options.save_baseline_path, results);
+		}
+
+		if (!options.baseline_path.empty()) {
+			auto regressions = compare_results(results, load_results(options.baseline_path), options.threshold);
+			if (regressions > 0) {
+				std::cout << regressions << " benchmarks are slower than baseline by more than " << options.threshold << "%" << std::endl;
+				return 1;
+			}
+		}
+
+		return 0;
+	}
+	catch (std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+}